@@ -31,9 +31,12 @@
 // utility functions from SyncEvolution are used
 // instead, plus standard C/Posix functions.
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/bind.hpp>
 
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <ctype.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
@@ -43,15 +46,45 @@
 #include <boost/algorithm/string/predicate.hpp>
 
 #include <sstream>
-#include <fstream>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
+/**
+ * Prefix for files which are still being written. Such files are
+ * ignored when listing items.
+ */
+static const char TMP_PREFIX[] = ".tmp-";
+
+/** sub-directory names in the sharded layout: "00" to "ff" */
+static bool IsShard(const char *name)
+{
+    return isxdigit(name[0]) && isxdigit(name[1]) && !name[2];
+}
+
+/** fsync() file or directory, ignores files which no longer exist */
+static void SyncPath(const string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return;
+        }
+        Exception::throwError(SE_HERE, path, errno);
+    }
+    if (fsync(fd)) {
+        int error = errno;
+        ::close(fd);
+        Exception::throwError(SE_HERE, path + ": fsync", error);
+    }
+    ::close(fd);
+}
+
 FileSyncSource::FileSyncSource(const SyncSourceParams &params,
                                const string &dataformat) :
     TrackingSyncSource(params),
     m_mimeType(dataformat),
+    m_sharded(false),
     m_entryCounter(0)
 {
     if (dataformat.empty()) {
@@ -76,6 +109,15 @@ FileSyncSource::FileSyncSource(const SyncSourceParams &params,
     }
 }
 
+FileSyncSource::~FileSyncSource()
+{
+    try {
+        finishItemChanges();
+    } catch (...) {
+        Exception::handle();
+    }
+}
+
 std::string FileSyncSource::getMimeType() const
 {
     return m_mimeType.c_str();
@@ -100,6 +142,7 @@ void FileSyncSource::open()
 {
     const string &database = getDatabaseID();
     const string prefix("file://");
+    const string shardedPrefix("sharded://");
     string basedir;
     bool createDir = false;
 
@@ -115,9 +158,14 @@ void FileSyncSource::open()
 
     // file:// is optional. It indicates that the
     // directory is to be created.
+    m_sharded = false;
     if (boost::starts_with(database, prefix)) {
         basedir = database.substr(prefix.size());
         createDir = true;
+    } else if (boost::starts_with(database, shardedPrefix)) {
+        basedir = database.substr(shardedPrefix.size());
+        createDir = true;
+        m_sharded = true;
     } else {
         basedir = database;
     }
@@ -133,30 +181,43 @@ void FileSyncSource::open()
 
     // success!
     m_basedir = basedir;
+
+    // insertItem() only uses the file system and members which the
+    // main thread doesn't touch without waiting for pending inserts.
+    enableInsertThread();
 }
 
 bool FileSyncSource::isEmpty()
+{
+    return !hasItems(m_basedir, m_sharded);
+}
+
+bool FileSyncSource::hasItems(const string &path, bool sharded)
 {
     DIR *dir = NULL;
-    bool empty = true;
+    bool found = false;
 
     try {
-        dir = opendir(m_basedir.c_str());
+        dir = opendir(path.c_str());
         if (!dir) {
-            Exception::throwError(SE_HERE, m_basedir, errno);
+            Exception::throwError(SE_HERE, path, errno);
         }
         errno = 0;
         struct dirent *entry = readdir(dir);
         while (entry) {
             if (strcmp(entry->d_name, ".") &&
-                strcmp(entry->d_name, "..")) {
-                empty = false;
+                strcmp(entry->d_name, "..") &&
+                !boost::starts_with(entry->d_name, TMP_PREFIX) &&
+                (!sharded ||
+                 (IsShard(entry->d_name) && hasItems(path + "/" + entry->d_name, false)))) {
+                found = true;
                 break;
             }
+            errno = 0;
             entry = readdir(dir);
         }
         if (errno) {
-            Exception::throwError(SE_HERE, m_basedir, errno);
+            Exception::throwError(SE_HERE, path, errno);
         }
     } catch(...) {
         if (dir) {
@@ -166,14 +227,45 @@ bool FileSyncSource::isEmpty()
     }
 
     closedir(dir);
-    return empty;
+    return found;
 }
 
 void FileSyncSource::close()
 {
+    flushItemChanges();
+    finishItemChanges();
     m_basedir.clear();
 }
 
+void FileSyncSource::flushItemChanges()
+{
+    // Runs after the pending inserts which fill m_pendingFiles and
+    // in the same thread; waiting happens in finishItemChanges().
+    scheduleWork(boost::bind(&FileSyncSource::syncPending, this));
+}
+
+std::string FileSyncSource::endSync(bool success)
+{
+    // Item data must be on disk before the tracking node records
+    // the new revisions.
+    flushItemChanges();
+    finishItemChanges();
+    return TrackingSyncSource::endSync(success);
+}
+
+void FileSyncSource::syncPending()
+{
+    // Files first, then the directories which contain their new names.
+    BOOST_FOREACH (const string &filename, m_pendingFiles) {
+        SyncPath(filename);
+    }
+    m_pendingFiles.clear();
+    BOOST_FOREACH (const string &dir, m_pendingDirs) {
+        SyncPath(dir);
+    }
+    m_pendingDirs.clear();
+}
+
 FileSyncSource::Databases FileSyncSource::getDatabases()
 {
     Databases result;
@@ -185,8 +277,6 @@ FileSyncSource::Databases FileSyncSource::getDatabases()
 
 void FileSyncSource::listAllItems(RevisionMap_t &revisions)
 {
-    ReadDir dirContent(m_basedir);
-
     std::string varname = StringPrintf("SYNCEVOLUTION_FILE_SOURCE_DELAY_LISTALL_%s", getDisplayName().c_str());
     boost::replace_all(varname, "-", "_");
     const char *delay = getenv(varname.c_str());
@@ -197,15 +287,65 @@ void FileSyncSource::listAllItems(RevisionMap_t &revisions)
         SE_LOG_DEBUG(getDisplayName(), "continue listing items in file source");
     }
 
-    BOOST_FOREACH(const string &entry, dirContent) {
-        string filename = createFilename(entry);
-        string revision = getATimeString(filename);
-        long entrynum = atoll(entry.c_str());
-        if (entrynum >= m_entryCounter) {
-            m_entryCounter = entrynum + 1;
+    listDir(m_basedir, "", revisions);
+}
+
+void FileSyncSource::listDir(const string &path, const string &prefix, RevisionMap_t &revisions)
+{
+    DIR *dir = NULL;
+
+    try {
+        dir = opendir(path.c_str());
+        if (!dir) {
+            Exception::throwError(SE_HERE, path, errno);
+        }
+        // stat() relative to the directory avoids resolving the
+        // full path again for each entry.
+        int fd = dirfd(dir);
+        errno = 0;
+        struct dirent *entry = readdir(dir);
+        while (entry) {
+            const char *name = entry->d_name;
+            if (strcmp(name, ".") &&
+                strcmp(name, "..") &&
+                !boost::starts_with(name, TMP_PREFIX)) {
+                if (m_sharded && prefix.empty()) {
+                    // Top level: only sub-directories contain items.
+                    // The entry type is usually known without stat().
+                    struct stat buf;
+                    if (IsShard(name) &&
+                        (entry->d_type == DT_DIR ||
+                         (entry->d_type == DT_UNKNOWN &&
+                          !fstatat(fd, name, &buf, 0) &&
+                          S_ISDIR(buf.st_mode)))) {
+                        listDir(path + "/" + name, string(name) + "/", revisions);
+                    }
+                } else {
+                    struct stat buf;
+                    if (fstatat(fd, name, &buf, 0)) {
+                        Exception::throwError(SE_HERE, path + "/" + name, errno);
+                    }
+                    long entrynum = atoll(name);
+                    if (entrynum >= m_entryCounter) {
+                        m_entryCounter = entrynum + 1;
+                    }
+                    revisions[prefix + name] = getATimeString(buf);
+                }
+            }
+            errno = 0;
+            entry = readdir(dir);
+        }
+        if (errno) {
+            Exception::throwError(SE_HERE, path, errno);
+        }
+    } catch(...) {
+        if (dir) {
+            closedir(dir);
         }
-        revisions[entry] = revision;
+        throw;
     }
+
+    closedir(dir);
 }
 
 void FileSyncSource::readItem(const string &uid, std::string &item, bool raw)
@@ -220,9 +360,52 @@ void FileSyncSource::readItem(const string &uid, std::string &item, bool raw)
 TrackingSyncSource::InsertItemResult FileSyncSource::insertItem(const string &uid, const std::string &item, bool raw)
 {
     string newuid = uid;
-    string creationTime;
     string filename;
 
+    // Write into a temporary file first, then move it into place,
+    // so that readers never see a partially written item. The
+    // temporary file is on the same file system as the final
+    // file, which is required for rename() and link().
+    string tmpname = StringPrintf("%s/%s%ld", m_basedir.c_str(), TMP_PREFIX, (long)getpid());
+    int fd = ::open(tmpname.c_str(), O_WRONLY|O_CREAT|O_EXCL, 0666);
+    if (fd < 0 && errno == EEXIST) {
+        // Left over from an earlier failure. Might still be linked
+        // to an item, so don't just truncate it.
+        unlink(tmpname.c_str());
+        fd = ::open(tmpname.c_str(), O_WRONLY|O_CREAT|O_EXCL, 0666);
+    }
+    if (fd < 0) {
+        throwError(SE_HERE, tmpname, errno);
+    }
+    // The modification time stamp is the revision string. It is
+    // not modified by moving the file.
+    struct stat buf;
+    try {
+        size_t written = 0;
+        while (written < item.size()) {
+            ssize_t res = write(fd, item.c_str() + written, item.size() - written);
+            if (res < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throwError(SE_HERE, tmpname + ": writing failed", errno);
+            }
+            written += res;
+        }
+        if (fstat(fd, &buf)) {
+            throwError(SE_HERE, tmpname, errno);
+        }
+    } catch (...) {
+        ::close(fd);
+        unlink(tmpname.c_str());
+        throw;
+    }
+    if (::close(fd)) {
+        int error = errno;
+        unlink(tmpname.c_str());
+        throwError(SE_HERE, tmpname + ": writing failed", error);
+    }
+
     // Inserting a new and updating an existing item often uses
     // very similar code. In this case only the code for determining
     // the filename differs.
@@ -234,41 +417,64 @@ TrackingSyncSource::InsertItemResult FileSyncSource::insertItem(const string &ui
     // existing one, then the existing one should be updated.
 
     if (uid.size()) {
-        // valid local ID: update that file
+        // valid local ID: replace that file
         filename = createFilename(uid);
+        if (rename(tmpname.c_str(), filename.c_str())) {
+            int error = errno;
+            unlink(tmpname.c_str());
+            throwError(SE_HERE, filename, error);
+        }
     } else {
-        // no local ID: create new file
+        // no local ID: create new file, link() fails instead of
+        // overwriting a file which exists already
         while (true) {
-            ostringstream buff;
-            buff << m_entryCounter;
-            filename = createFilename(buff.str());
-
-            // only create and truncate if file does not
-            // exist yet, otherwise retry with next counter
-            struct stat dummy;
-            if (stat(filename.c_str(), &dummy)) {
-                if (errno == ENOENT) {
-                    newuid = buff.str();
-                    break;
-                } else {
-                    throwError(SE_HERE, filename, errno);
+            newuid = m_sharded ?
+                StringPrintf("%02lx/%ld", m_entryCounter & 0xFF, m_entryCounter) :
+                StringPrintf("%ld", m_entryCounter);
+            filename = createFilename(newuid);
+            if (!link(tmpname.c_str(), filename.c_str())) {
+                unlink(tmpname.c_str());
+                break;
+            }
+            int error = errno;
+            if (error == ENOENT && m_sharded) {
+                // create missing sub-directory, then try again
+                string dir = filename.substr(0, filename.rfind('/'));
+                if (mkdir(dir.c_str(), 0777) && errno != EEXIST) {
+                    error = errno;
+                    unlink(tmpname.c_str());
+                    throwError(SE_HERE, dir, error);
+                }
+                m_pendingDirs.insert(m_basedir);
+                continue;
+            } else if (error == EPERM || error == ENOTSUP || error == ENOSYS) {
+                // File system without hard links: check for existing
+                // file, then move.
+                struct stat dummy;
+                if (stat(filename.c_str(), &dummy)) {
+                    if (errno == ENOENT &&
+                        !rename(tmpname.c_str(), filename.c_str())) {
+                        break;
+                    }
+                    error = errno;
+                    unlink(tmpname.c_str());
+                    throwError(SE_HERE, filename, error);
                 }
+            } else if (error != EEXIST) {
+                unlink(tmpname.c_str());
+                throwError(SE_HERE, filename, error);
             }
 
             m_entryCounter++;
         }
+        m_entryCounter++;
     }
 
-    ofstream out;
-    out.open(filename.c_str());
-    out.write(item.c_str(), item.size());
-    out.close();
-    if (!out.good()) {
-        throwError(SE_HERE, filename + ": writing failed", errno);
-    }
+    m_pendingFiles.insert(filename);
+    m_pendingDirs.insert(filename.substr(0, filename.rfind('/')));
 
     return InsertItemResult(newuid,
-                            getATimeString(filename),
+                            getATimeString(buf),
                             ITEM_OKAY);
 }
 
@@ -280,6 +486,8 @@ void FileSyncSource::removeItem(const string &uid)
     if (unlink(filename.c_str())) {
         throwError(SE_HERE, filename, errno);
     }
+    m_pendingFiles.erase(filename);
+    m_pendingDirs.insert(filename.substr(0, filename.rfind('/')));
 }
 
 string FileSyncSource::getATimeString(const string &filename)
@@ -288,6 +496,11 @@ string FileSyncSource::getATimeString(const string &filename)
     if (stat(filename.c_str(), &buf)) {
         throwError(SE_HERE, filename, errno);
     }
+    return getATimeString(buf);
+}
+
+string FileSyncSource::getATimeString(const struct stat &buf)
+{
     time_t mtime = buf.st_mtime;
     int mnsec = buf.st_mtim.tv_nsec;
 
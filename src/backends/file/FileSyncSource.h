@@ -25,8 +25,11 @@
 #ifdef ENABLE_FILE
 
 #include <memory>
+#include <set>
 #include <boost/noncopyable.hpp>
 
+#include <sys/stat.h>
+
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
@@ -46,6 +49,19 @@ SE_BEGIN_CXX
  * initialized based on the initial content of the directory to
  * "highest existing number + 1" and incremented to avoid collisions.
  *
+ * With sharded://<path> as database name, the directory is always
+ * created and items are spread across 256 sub-directories "00" to
+ * "ff" (by running count). The local ID then is "<sub-directory>/<name>".
+ * This keeps directories small when storing many items.
+ *
+ * Files are written to a temporary file first and then renamed,
+ * so readers never see partially written items. Writing the data
+ * to disk is delayed until flushItemChanges() or the end of the sync
+ * and then done for all modified files together. Writing and syncing
+ * happen in a separate thread (see TrackingSyncSource::enableInsertThread()),
+ * so several file datastores in the same sync store their items
+ * in parallel.
+ *
  * Although this sync source itself does not care about the content of
  * each item/file, the server needs to know what each item sent to it
  * contains and what items the source is able to receive. Therefore
@@ -59,7 +75,7 @@ class FileSyncSource : public TrackingSyncSource, public SyncSourceLogging, priv
   public:
     FileSyncSource(const SyncSourceParams &params,
                    const string &dataformat);
-
+    ~FileSyncSource();
 
  protected:
     /* implementation of SyncSource interface */
@@ -75,6 +91,8 @@ class FileSyncSource : public TrackingSyncSource, public SyncSourceLogging, priv
     virtual InsertItemResult insertItem(const string &luid, const std::string &item, bool raw);
     void readItem(const std::string &luid, std::string &item, bool raw);
     virtual void removeItem(const string &uid);
+    virtual void flushItemChanges();
+    virtual std::string endSync(bool success);
 
  private:
     /**
@@ -89,15 +107,38 @@ class FileSyncSource : public TrackingSyncSource, public SyncSourceLogging, priv
 
     /** directory selected via the database name in open(), reset in close() */
     string m_basedir;
+    /** items are stored in sub-directories of m_basedir */
+    bool m_sharded;
     /** a counter which is used to name new files */
     long m_entryCounter;
 
+    /** files and directories modified since the last syncPending() */
+    std::set<std::string> m_pendingFiles, m_pendingDirs;
+
+    /** write modified files and directories to disk, called via scheduleWork() */
+    void syncPending();
+
+    /**
+     * add all items in the directory, using one directory file
+     * descriptor for reading meta data
+     *
+     * @param dir         absolute path of directory
+     * @param prefix      added to file name to create the local ID
+     */
+    void listDir(const string &dir, const string &prefix, RevisionMap_t &revisions);
+
+    /** true if the directory contains items */
+    bool hasItems(const string &dir, bool sharded);
+
     /**
      * get access time for file, formatted as revision string
      * @param filename    absolute path or path relative to current directory
      */
     string getATimeString(const string &filename);
 
+    /** same as getATimeString() for an already known stat result */
+    static string getATimeString(const struct stat &buf);
+
     /**
      * create full filename from basedir and entry name
      */
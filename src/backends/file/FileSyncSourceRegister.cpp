@@ -64,6 +64,9 @@ static RegisterSyncSource registerMe("Files in one directory",
                                      "   The directory is selected via database=[file://]<path>.\n"
                                      "   It will only be created if the prefix is given, otherwise\n"
                                      "   it must exist already.\n"
+                                     "   With database=sharded://<path>, the directory is created\n"
+                                     "   if necessary and items are spread across sub-directories.\n"
+                                     "   Better suited for many items.\n"
                                      "   The database format *must* be specified explicitly. It may be\n"
                                      "   different from the sync format, as long as there are\n"
                                      "   conversion rules (for example, vCard 2.1 <-> vCard 3.0). If\n"
@@ -74,7 +77,8 @@ static RegisterSyncSource registerMe("Files in one directory",
                                      "      text/calendar\n"
                                      "   Examples for evolutionsource:\n"
                                      "      /home/joe/datadir - directory must exist\n"
-                                     "      file:///tmp/scratch - directory is created\n",
+                                     "      file:///tmp/scratch - directory is created\n"
+                                     "      sharded:///tmp/many - directory with sub-directories\n",
                                      Values() +
                                      (Aliases("file") + "Files in one directory"));
 
@@ -160,6 +164,32 @@ public:
     }
 } ITodo20Test;
 
+// Same as VCard30Test and ICal20Test, but with the sharded
+// directory layout (database=sharded://<path>, chosen by
+// client-test for all file_sharded_* configs).
+static class ShardedVCard30Test : public RegisterSyncSourceTest {
+public:
+    ShardedVCard30Test() : RegisterSyncSourceTest("file_sharded_contact", "eds_contact") {}
+
+    virtual void updateConfig(ClientTestConfig &config) const
+    {
+        config.m_sourceKnowsItemSemantic = false;
+        config.m_type = "file:text/vcard:3.0";
+    }
+} ShardedVCard30Test;
+
+static class ShardedICal20Test : public RegisterSyncSourceTest {
+public:
+    ShardedICal20Test() : RegisterSyncSourceTest("file_sharded_event", "eds_event") {}
+
+    virtual void updateConfig(ClientTestConfig &config) const
+    {
+        // see ICal20Test
+        config.m_sourceKnowsItemSemantic = false;
+        config.m_type = "file:text/calendar:2.0";
+    }
+} ShardedICal20Test;
+
 static class SuperTest : public RegisterSyncSourceTest {
 public:
     SuperTest() : RegisterSyncSourceTest("file_calendar+todo", "calendar+todo") {}
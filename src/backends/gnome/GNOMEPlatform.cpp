@@ -112,6 +112,105 @@ static bool IsSharedSecretError(const GErrorCXX &gerror)
     return result;
 }
 
+/**
+ * One asynchronous password lookup. Owned by the pending libsecret
+ * call and deleted when done.
+ */
+class LibSecretLookup : private boost::noncopyable
+{
+    LibSecretHash m_hash;
+    std::string m_descr;
+    ConfigPasswordKey m_key;
+    boost::function<void (const InitStateString &)> m_success;
+    boost::function<void ()> m_failureException;
+    int m_attempt;
+
+    static void done(GObject *source, GAsyncResult *result, gpointer userData) throw ()
+    {
+        std::unique_ptr<LibSecretLookup> lookup(static_cast<LibSecretLookup *>(userData));
+        try {
+            GErrorCXX gerror;
+            PlainGStr password(secret_password_lookup_finish(result, gerror));
+
+            if (gerror) {
+                /* It is uncertain whether we end up here at all when such
+                   an error occurs. Check just in case. */
+                if (IsSharedSecretError(gerror) &&
+                    lookup->m_attempt < 3) {
+                    SE_LOG_DEBUG(NULL, "disconnecting secret service: %u/%d = %s", gerror->domain, gerror->code, gerror->message);
+                    secret_service_disconnect();
+                    lookup.release()->start();
+                    return;
+                }
+                gerror.throwError(SE_HERE, StringPrintf("looking up password '%s'", lookup->m_descr.c_str()));
+            } else if (password.get()) {
+                SE_LOG_DEBUG(NULL, "%s: loaded password from GNOME keyring using %s",
+                             lookup->m_key.description.c_str(),
+                             lookup->m_key.toString().c_str());
+                lookup->m_success(InitStateString(password.get(), true));
+            } else if (lookup->m_attempt < 3) {
+                /*
+                 * There have been cases where "received an invalid or
+                 * unencryptable secret" was printed to the console right
+                 * before we end up here. Apparently the error doesn't
+                 * get propagated properly to us.
+                 *
+                 * To cope with that, we try to disconnect and check again.
+                 */
+                SE_LOG_DEBUG(NULL, "disconnecting secret service: password not found");
+                secret_service_disconnect();
+                lookup.release()->start();
+            } else {
+                SE_LOG_DEBUG(NULL, "password not in GNOME keyring using %s",
+                             lookup->m_key.toString().c_str());
+                lookup->m_success(InitStateString());
+            }
+        } catch (...) {
+            lookup->m_failureException();
+        }
+    }
+
+ public:
+    LibSecretLookup(const std::string &descr,
+                    const ConfigPasswordKey &key,
+                    const boost::function<void (const InitStateString &)> &success,
+                    const boost::function<void ()> &failureException) :
+        m_hash(key),
+        m_descr(descr),
+        m_key(key),
+        m_success(success),
+        m_failureException(failureException),
+        m_attempt(0)
+    {}
+
+    /** start next attempt, ownership is transferred to the pending call */
+    void start()
+    {
+        m_attempt++;
+        secret_password_lookupv(SECRET_SCHEMA_COMPAT_NETWORK,
+                                m_hash,
+                                NULL,
+                                done,
+                                this);
+    }
+};
+
+bool GNOMELoadPasswordAsyncSlot(const InitStateTri &keyring,
+                                const std::string &passwordName,
+                                const std::string &descr,
+                                const ConfigPasswordKey &key,
+                                const boost::function<void (const InitStateString &)> &success,
+                                const boost::function<void ()> &failureException)
+{
+    if (!UseGNOMEKeyring(keyring)) {
+        SE_LOG_DEBUG(NULL, "not using GNOME keyring");
+        return false;
+    }
+
+    (new LibSecretLookup(descr, key, success, failureException))->start();
+    return true;
+}
+
 bool GNOMELoadPasswordSlot(const InitStateTri &keyring,
                            const std::string &passwordName,
                            const std::string &descr,
@@ -35,6 +35,13 @@ bool GNOMELoadPasswordSlot(const InitStateTri &keyring,
                            const ConfigPasswordKey &key,
                            InitStateString &password);
 
+bool GNOMELoadPasswordAsyncSlot(const InitStateTri &keyring,
+                                const std::string &passwordName,
+                                const std::string &descr,
+                                const ConfigPasswordKey &key,
+                                const boost::function<void (const InitStateString &)> &success,
+                                const boost::function<void ()> &failureException);
+
 bool GNOMESavePasswordSlot(const InitStateTri &keyring,
                            const std::string &passwordName,
                            const std::string &password,
@@ -32,6 +32,7 @@ public:
     GNOMEInit()
     {
         GetLoadPasswordSignal().connect(1, GNOMELoadPasswordSlot);
+        GetLoadPasswordAsyncSignal().connect(1, GNOMELoadPasswordAsyncSlot);
         GetSavePasswordSignal().connect(1, GNOMESavePasswordSlot);
     }
 } gnomeinit;
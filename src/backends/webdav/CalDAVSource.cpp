@@ -104,15 +104,13 @@ void CalDAVSource::listAllSubItems(SubRevisionMap_t &revisions)
     Timespec deadline = createDeadline();
     getSession()->startOperation("REPORT 'meta data'", deadline);
     while (true) {
-        string data;
         Neon::XMLParser parser;
-        parser.initReportParser(boost::bind(&CalDAVSource::appendItem, this,
-                                            boost::ref(revisions),
-                                            _1, _2, boost::ref(data)));
+        parser.initDataReportParser("urn:ietf:params:xml:ns:caldav", "calendar-data",
+                                    boost::bind(&CalDAVSource::appendItem, this,
+                                                boost::ref(revisions),
+                                                _1, _2, _3));
         m_cache.clear();
         m_cache.m_initialized = false;
-        parser.pushHandler(boost::bind(Neon::XMLParser::accept, "urn:ietf:params:xml:ns:caldav", "calendar-data", _2, _3),
-                           boost::bind(Neon::XMLParser::append, boost::ref(data), _2, _3));
         Neon::Request report(*getSession(), "REPORT", getCalendar().m_path, query, parser);
         report.addHeader("Depth", "1");
         report.addHeader("Content-Type", "application/xml; charset=\"utf-8\"");
@@ -248,14 +246,12 @@ void CalDAVSource::updateAllSubItems(SubRevisionMap_t &revisions)
         std::set<std::string> results; // LUIDs of all hrefs returned by report
         getSession()->startOperation("updateAllSubItems REPORT 'multiget new/updated items'", deadline);
         while (true) {
-            string data;
             Neon::XMLParser parser;
-            parser.initReportParser(boost::bind(&CalDAVSource::appendMultigetResult, this,
-                                                boost::ref(revisions),
-                                                boost::ref(results),
-                                                _1, _2, boost::ref(data)));
-            parser.pushHandler(boost::bind(Neon::XMLParser::accept, "urn:ietf:params:xml:ns:caldav", "calendar-data", _2, _3),
-                               boost::bind(Neon::XMLParser::append, boost::ref(data), _2, _3));
+            parser.initDataReportParser("urn:ietf:params:xml:ns:caldav", "calendar-data",
+                                        boost::bind(&CalDAVSource::appendMultigetResult, this,
+                                                    boost::ref(revisions),
+                                                    boost::ref(results),
+                                                    _1, _2, _3));
             Neon::Request report(*getSession(), "REPORT", getCalendar().m_path,
                                  query, parser);
             report.addHeader("Depth", "1");
@@ -1059,6 +1055,14 @@ CalDAVSource::Event &CalDAVSource::findItem(const std::string &davLUID)
     return *it->second;
 }
 
+std::string CalDAVSource::expectedRevision(const std::string &davLUID)
+{
+    // Change tracking is done by MapSyncSource for sub-items,
+    // the ETag of each merged item is in our cache.
+    EventCache::iterator it = m_cache.find(davLUID);
+    return it == m_cache.end() ? "" : it->second->m_etag;
+}
+
 CalDAVSource::Event &CalDAVSource::loadItem(const std::string &davLUID)
 {
     Event &event = findItem(davLUID);
@@ -1366,13 +1370,11 @@ void CalDAVSource::backupData(const SyncSource::Operations::ConstBackupInfo &old
         "</C:comp-filter>\n"
         "</C:filter>\n"
         "</C:calendar-query>\n";
-    string data;
     Neon::XMLParser parser;
-    parser.initReportParser(boost::bind(&CalDAVSource::backupItem, this,
-                                        boost::ref(cache),
-                                        _1, _2, boost::ref(data)));
-    parser.pushHandler(boost::bind(Neon::XMLParser::accept, "urn:ietf:params:xml:ns:caldav", "calendar-data", _2, _3),
-                       boost::bind(Neon::XMLParser::append, boost::ref(data), _2, _3));
+    parser.initDataReportParser("urn:ietf:params:xml:ns:caldav", "calendar-data",
+                                boost::bind(&CalDAVSource::backupItem, this,
+                                            boost::ref(cache),
+                                            _1, _2, _3));
     Timespec deadline = createDeadline();
     getSession()->startOperation("REPORT 'full calendar'", deadline);
     while (true) {
@@ -1404,8 +1406,6 @@ int CalDAVSource::backupItem(ItemCache &cache,
         SE_LOG_DEBUG(NULL, "ignoring broken item %s during backup (is empty)", href.c_str());
     }
 
-    // reset data for next item
-    data.clear();
     return 0;
 }
 
@@ -79,6 +79,10 @@ class CalDAVSource : public WebDAVSource,
     virtual std::string suffix() const { return ".ics"; }
     virtual std::string getContent() const { return "VEVENT"; }
     virtual bool getContentMixed() const { return true; }
+    /** MapSyncSource needs the result of insertItem() right away */
+    virtual bool parallelWritesSupported() const { return false; }
+    /** ETag of the merged item as found in m_cache */
+    virtual std::string expectedRevision(const std::string &davLUID);
 
  private:
     /**
@@ -41,6 +41,12 @@ class CalDAVVxxSource : public WebDAVSource,
                     const SyncSourceParams &params,
                     const boost::shared_ptr<SyncEvo::Neon::Settings> &settings);
 
+    /**
+     * Pending item changes use virtual methods of this instance,
+     * must wait for them before destructing it.
+     */
+    ~CalDAVVxxSource() { finishItemChanges(); }
+
     /* implementation of SyncSourceSerialize interface */
     virtual std::string getMimeType() const {
         return m_content == "VJOURNAL" ?
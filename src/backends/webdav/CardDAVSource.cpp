@@ -201,17 +201,15 @@ boost::shared_ptr<CardDAVCache> CardDAVSource::readBatch(const std::string &luid
             }
             query << "</C:addressbook-multiget>";
 
-            string data;
             Neon::XMLParser parser;
             // This removes all items for which we get data from luids.
             // The purpose of that is two-fold: don't request data again that
             // we already got when resending, and detect missing 404 status errors
             // with Google.
-            parser.initReportParser(boost::bind(&CardDAVSource::addItemToCache, this,
-                                                cache, boost::ref(luids),
-                                                _1, _2, boost::ref(data)));
-            parser.pushHandler(boost::bind(Neon::XMLParser::accept, "urn:ietf:params:xml:ns:carddav", "address-data", _2, _3),
-                               boost::bind(Neon::XMLParser::append, boost::ref(data), _2, _3));
+            parser.initDataReportParser("urn:ietf:params:xml:ns:carddav", "address-data",
+                                        boost::bind(&CardDAVSource::addItemToCache, this,
+                                                    cache, boost::ref(luids),
+                                                    _1, _2, _3));
             std::string request = query.str();
             Neon::Request req(*getSession(), "REPORT", getCalendar().m_path,
                               request, parser);
@@ -236,26 +234,28 @@ boost::shared_ptr<CardDAVCache> CardDAVSource::readBatch(const std::string &luid
     return cache;
 }
 
-void CardDAVSource::addItemToCache(boost::shared_ptr<CardDAVCache> &cache,
-                                   BatchLUIDs &luids,
-                                   const std::string &href,
-                                   const std::string &etag,
-                                   std::string &data)
+int CardDAVSource::addItemToCache(boost::shared_ptr<CardDAVCache> &cache,
+                                  BatchLUIDs &luids,
+                                  const std::string &href,
+                                  const std::string &etag,
+                                  std::string &data)
 {
     std::string luid = path2luid(href);
 
     // TODO: error checking
-    CardDAVCache::mapped_type result;
+    CardDAVCache::mapped_type &result = (*cache)[luid];
     if (!data.empty()) {
-        result = data;
         SE_LOG_DEBUG(getDisplayName(), "batch response: got %ld bytes of data for %s",
                      (long)data.size(), luid.c_str());
+        // take over the data instead of copying it
+        result = std::string();
+        boost::get<std::string>(result).swap(data);
     } else {
         SE_LOG_DEBUG(getDisplayName(), "batch response: unknown failure for %s",
                      luid.c_str());
+        result = CardDAVCache::mapped_type();
     }
 
-    (*cache)[luid] = result;
     bool found = false;
     for (BatchLUIDs::iterator it = luids.begin();
          it != luids.end();
@@ -270,9 +270,7 @@ void CardDAVSource::addItemToCache(boost::shared_ptr<CardDAVCache> &cache,
         SE_LOG_DEBUG(getDisplayName(), "batch response: unexpected item: %s = %s",
                      href.c_str(), luid.c_str());
     }
-
-    // reset data for next item
-    data.clear();
+    return 0;
 }
 
 CardDAVSource::InsertItemResult CardDAVSource::insertItem(const string &luid, const std::string &item, bool raw)
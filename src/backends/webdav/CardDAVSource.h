@@ -28,6 +28,12 @@ class CardDAVSource : public WebDAVSource,
  public:
     CardDAVSource(const SyncSourceParams &params, const boost::shared_ptr<SyncEvo::Neon::Settings> &settings);
 
+    /**
+     * Pending item changes use virtual methods of this instance,
+     * must wait for them before destructing it.
+     */
+    ~CardDAVSource() { finishItemChanges(); }
+
     /* implementation of SyncSourceSerialize interface */
     virtual std::string getMimeType() const { return "text/vcard"; }
     virtual std::string getMimeVersion() const { return "3.0"; }
@@ -70,11 +76,11 @@ class CardDAVSource : public WebDAVSource,
     void logCacheStats(Logger::Level level);
     boost::shared_ptr<CardDAVCache> readBatch(const std::string &luid);
     void invalidateCachedItem(const std::string &luid);
-    void addItemToCache(boost::shared_ptr<CardDAVCache> &cache,
-                        BatchLUIDs &luids,
-                        const std::string &href,
-                        const std::string &etag,
-                        std::string &data);
+    int addItemToCache(boost::shared_ptr<CardDAVCache> &cache,
+                       BatchLUIDs &luids,
+                       const std::string &href,
+                       const std::string &etag,
+                       std::string &data);
     void readItemInternal(const std::string &luid, std::string &item, bool raw);
 };
 
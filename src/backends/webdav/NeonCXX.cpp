@@ -16,6 +16,7 @@
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/lambda/lambda.hpp>
 
 #include <syncevo/util.h>
@@ -291,6 +292,34 @@ boost::shared_ptr<Session> Session::create(const boost::shared_ptr<Settings> &se
     return m_cachedSession;
 }
 
+std::list< boost::shared_ptr<Session> > Session::m_idleSessions;
+
+boost::shared_ptr<Session> Session::claim(const boost::shared_ptr<Settings> &settings)
+{
+    URI uri = URI::parse(settings->getURL());
+    std::string proxy = settings->proxy();
+    for (std::list< boost::shared_ptr<Session> >::iterator it = m_idleSessions.begin();
+         it != m_idleSessions.end();
+         ++it) {
+        if ((*it)->m_uri == uri &&
+            (*it)->m_proxyURL == proxy) {
+            boost::shared_ptr<Session> session = *it;
+            m_idleSessions.erase(it);
+            session->m_settings = settings;
+            return session;
+        }
+    }
+    // Idle sessions for some other server are not going to be needed
+    // anymore.
+    m_idleSessions.clear();
+    return boost::shared_ptr<Session>(new Session(settings));
+}
+
+void Session::release(const boost::shared_ptr<Session> &session)
+{
+    m_idleSessions.push_back(session);
+}
+
 
 int Session::getCredentials(void *userdata, const char *realm, int attempt, char *username, char *password) throw()
 {
@@ -930,6 +959,28 @@ void XMLParser::initReportParser(const VoidResponseEndCB_t &responseEnd)
     }
 }
 
+static int DataResponseEndCBWrapper(const XMLParser::DataResponseEndCB_t &responseEnd,
+                                    std::string &data,
+                                    const std::string &href,
+                                    const std::string &etag,
+                                    const std::string &status)
+{
+    int abort = responseEnd(href, etag, data);
+    // clear() keeps the capacity, so the next item usually
+    // fits without reallocating
+    data.clear();
+    return abort;
+}
+
+void XMLParser::initDataReportParser(const std::string &nspace,
+                                     const std::string &name,
+                                     const DataResponseEndCB_t &responseEnd)
+{
+    initAbortingReportParser(boost::bind(DataResponseEndCBWrapper, responseEnd, boost::ref(m_data), _1, _2, _3));
+    pushHandler(boost::bind(Neon::XMLParser::accept, nspace, name, _2, _3),
+                boost::bind(Neon::XMLParser::append, boost::ref(m_data), _2, _3));
+}
+
 
 Request::Request(Session &session,
                  const std::string &method,
@@ -1035,6 +1086,145 @@ int Request::addResultData(void *userdata, const char *buf, size_t len)
     return 0;
 }
 
+/**
+ * Settings are shared by sessions running in different threads.
+ * Serialize all calls, because the underlying implementation might
+ * not be thread-safe (setCredentialsOkay() for example writes to a
+ * config node).
+ */
+class SerializedSettings : public Settings
+{
+    boost::shared_ptr<Settings> m_settings;
+    static RecMutex m_mutex;
+
+public:
+    SerializedSettings(const boost::shared_ptr<Settings> &settings) :
+        m_settings(settings)
+    {}
+
+    virtual std::string getURL() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->getURL(); }
+    virtual bool verifySSLHost() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->verifySSLHost(); }
+    virtual bool verifySSLCertificate() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->verifySSLCertificate(); }
+    virtual std::string proxy() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->proxy(); }
+    virtual void getCredentials(const std::string &realm,
+                                std::string &username,
+                                std::string &password) {
+        RecMutex::Guard guard = m_mutex.lock();
+        m_settings->getCredentials(realm, username, password);
+    }
+    virtual boost::shared_ptr<AuthProvider> getAuthProvider() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->getAuthProvider(); }
+    virtual void updatePassword(const std::string& password) { RecMutex::Guard guard = m_mutex.lock(); m_settings->updatePassword(password); }
+    virtual bool getCredentialsOkay() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->getCredentialsOkay(); }
+    virtual void setCredentialsOkay(bool okay) { RecMutex::Guard guard = m_mutex.lock(); m_settings->setCredentialsOkay(okay); }
+    virtual int logLevel() { RecMutex::Guard guard = m_mutex.lock(); return m_settings->logLevel(); }
+    virtual bool googleUpdateHack() const { RecMutex::Guard guard = m_mutex.lock(); return m_settings->googleUpdateHack(); }
+    virtual bool googleAlarmHack() const { RecMutex::Guard guard = m_mutex.lock(); return m_settings->googleAlarmHack(); }
+    virtual int timeoutSeconds() const { RecMutex::Guard guard = m_mutex.lock(); return m_settings->timeoutSeconds(); }
+    virtual int retrySeconds() const { RecMutex::Guard guard = m_mutex.lock(); return m_settings->retrySeconds(); }
+};
+
+RecMutex SerializedSettings::m_mutex;
+
+RequestScheduler::RequestScheduler(const boost::shared_ptr<Settings> &settings,
+                                   int maxParallel) :
+    m_settings(new SerializedSettings(settings)),
+    m_maxParallel(std::max(maxParallel, 1))
+{
+#ifndef HAVE_THREAD_SUPPORT
+    m_maxParallel = 1;
+#endif
+    SE_LOG_DEBUG(NULL, "running up to %d requests in parallel", m_maxParallel);
+}
+
+RequestScheduler::~RequestScheduler()
+{
+#ifdef HAVE_THREAD_SUPPORT
+    finish();
+    m_queue.shutdown();
+
+    BOOST_FOREACH (const boost::shared_ptr<Worker> &worker, m_workers) {
+        g_thread_join(worker->m_thread);
+        Session::release(worker->m_session);
+    }
+#endif
+}
+
+void RequestScheduler::runOperation(Pending &pending, Session &session)
+{
+    try {
+        pending.m_operation(session);
+    } catch (...) {
+        // Reported to the main thread by check().
+        Exception::handle(pending.m_failure, HANDLE_EXCEPTION_NO_ERROR);
+    }
+}
+
+boost::shared_ptr<RequestScheduler::Pending> RequestScheduler::schedule(const Operation_t &operation)
+{
+    boost::shared_ptr<Pending> pending(new Pending(operation));
+
+#ifdef HAVE_THREAD_SUPPORT
+    {
+        bool startWorker = m_queue.push(pending) &&
+            m_workers.size() < (size_t)m_maxParallel;
+        if (startWorker) {
+            // Sessions must be created in the main thread.
+            boost::shared_ptr<Worker> worker(new Worker);
+            worker->m_scheduler = this;
+            worker->m_session = Session::claim(m_settings);
+            worker->m_session->forceAuthorization(Session::AUTH_HTTPS, m_settings->getAuthProvider());
+            worker->m_thread = g_thread_new("neon", workerThread, worker.get());
+            m_workers.push_back(worker);
+            SE_LOG_DEBUG(NULL, "started request worker #%d", (int)m_workers.size());
+        }
+        return pending;
+    }
+#endif
+
+    runOperation(*pending, *Session::create(m_settings));
+    pending->m_done = true;
+    return pending;
+}
+
+bool RequestScheduler::isDone(const boost::shared_ptr<Pending> &pending)
+{
+#ifdef HAVE_THREAD_SUPPORT
+    return m_queue.isDone(pending);
+#else
+    return pending->m_done;
+#endif
+}
+
+void RequestScheduler::check(const boost::shared_ptr<Pending> &pending)
+{
+#ifdef HAVE_THREAD_SUPPORT
+    m_queue.wait(pending);
+#endif
+    if (!pending->m_failure.empty()) {
+        Exception::tryRethrow(pending->m_failure, true);
+    }
+}
+
+void RequestScheduler::finish()
+{
+#ifdef HAVE_THREAD_SUPPORT
+    int numPending = m_queue.getNumPending();
+    if (numPending) {
+        SE_LOG_DEBUG(NULL, "waiting for %d pending requests", numPending);
+        m_queue.finish();
+    }
+#endif
+}
+
+#ifdef HAVE_THREAD_SUPPORT
+gpointer RequestScheduler::workerThread(gpointer data)
+{
+    Worker *worker = static_cast<Worker *>(data);
+    worker->m_scheduler->m_queue.run(boost::bind(runOperation, _1, boost::ref(*worker->m_session)));
+    return NULL;
+}
+#endif
+
 }
 
 SE_END_CXX
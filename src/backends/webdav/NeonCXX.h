@@ -24,9 +24,11 @@ using namespace std;
 
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
 
 
 #include <syncevo/util.h>
+#include <syncevo/ThreadSupport.h>
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
@@ -41,6 +43,7 @@ namespace Neon {
 std::string features();
 
 class Request;
+class RequestScheduler;
 
 /**
  * Throwing this will stop all further attempts to use the
@@ -313,6 +316,31 @@ class Session {
     Session(const boost::shared_ptr<Settings> &settings);
     static boost::shared_ptr<Session> m_cachedSession;
 
+    /**
+     * Additional sessions which are currently not in use. They get
+     * claimed by a RequestScheduler for running requests in parallel
+     * to m_cachedSession and are kept alive afterwards for the same
+     * reason as m_cachedSession: to avoid proxy setup and reconnecting.
+     * Only sessions for the server and proxy of the most recent
+     * claim() are kept.
+     */
+    static std::list< boost::shared_ptr<Session> > m_idleSessions;
+
+    /**
+     * Get an unused session for the server defined by the settings,
+     * from m_idleSessions if possible, otherwise new. Must be called
+     * in the main thread.
+     */
+    static boost::shared_ptr<Session> claim(const boost::shared_ptr<Settings> &settings);
+
+    /**
+     * Return a session obtained via claim(). Must be called in the
+     * main thread.
+     */
+    static void release(const boost::shared_ptr<Session> &session);
+
+    friend class RequestScheduler;
+
     ForceAuthorization m_forceAuthorizationOnce;
     boost::shared_ptr<AuthProvider> m_authProvider;
 
@@ -586,6 +614,29 @@ class XMLParser
     void initReportParser(const VoidResponseEndCB_t &responseEnd = VoidResponseEndCB_t());
     void initAbortingReportParser(const ResponseEndCB_t &responseEnd);
 
+    /**
+     * Called at the end of each response with href, etag and the
+     * item data collected by initDataReportParser(). The callback
+     * may modify the data or take it over with swap(). Afterwards the
+     * buffer is cleared for the next response, which keeps its memory
+     * allocated.
+     *
+     * @return non-zero for aborting the parsing
+     */
+    typedef boost::function<int (const std::string &, const std::string &, std::string &)> DataResponseEndCB_t;
+
+    /**
+     * Same as initReportParser(), plus collecting the content of
+     * the element with the given namespace and name (for example,
+     * "urn:ietf:params:xml:ns:caldav" "calendar-data") in a buffer
+     * owned by the parser. The same buffer is used for all
+     * responses, so even a large REPORT result is handled without
+     * more memory than needed for the largest item.
+     */
+    void initDataReportParser(const std::string &nspace,
+                              const std::string &name,
+                              const DataResponseEndCB_t &responseEnd);
+
  private:
     ne_xml_parser *m_parser;
     struct Callbacks {
@@ -605,6 +656,9 @@ class XMLParser
     /** buffers for initReportParser() */
     std::string m_href, m_etag, m_status;
 
+    /** buffer for initDataReportParser() */
+    std::string m_data;
+
     int doResponseEnd(const ResponseEndCB_t &responseEnd) {
         int abort = 0;
         if (responseEnd) {
@@ -718,6 +772,108 @@ class RedirectException : public TransportException
     std::string getLocation() const { return m_url; }
 };
 
+/**
+ * Runs independent operations in the background. Each operation gets
+ * executed in a worker thread with a Session of its own, so up to
+ * maxParallel requests can be in flight at the same time while the
+ * main thread continues with other work.
+ *
+ * Without thread support, operations are executed directly inside
+ * schedule(), i.e. with the same behavior as before.
+ *
+ * The scheduler itself must only be used in the main thread. The
+ * operations must not touch state which is also used by the main
+ * thread without locking; in particular they must use the Session
+ * that they are given and not the one used by the main thread.
+ *
+ * Settings are shared between all sessions. The scheduler therefore
+ * wraps them so that calls are serialized; use getSettings() also for
+ * the session of the main thread.
+ */
+class RequestScheduler : private boost::noncopyable
+{
+ public:
+    /**
+     * Does the actual work, using the given session.
+     * Errors are reported via exceptions.
+     */
+    typedef boost::function<void (Session &)> Operation_t;
+
+    /**
+     * Represents one scheduled operation. Only to be used via
+     * RequestScheduler::isDone() and RequestScheduler::check().
+     */
+    class Pending
+    {
+        friend class RequestScheduler;
+#ifdef HAVE_THREAD_SUPPORT
+        friend class WorkQueue<Pending>;
+#endif
+        Operation_t m_operation;
+        bool m_done;
+        /** Exception::handle() explanation if m_operation failed */
+        std::string m_failure;
+
+    public:
+        Pending(const Operation_t &operation) :
+            m_operation(operation),
+            m_done(false)
+        {}
+    };
+
+    /**
+     * @param settings      settings shared by all sessions
+     * @param maxParallel   maximum number of concurrent requests
+     */
+    RequestScheduler(const boost::shared_ptr<Settings> &settings,
+                     int maxParallel);
+
+    /** waits for completion of all pending operations */
+    ~RequestScheduler();
+
+    /** settings which are safe to use in the main thread while operations run */
+    boost::shared_ptr<Settings> getSettings() const { return m_settings; }
+
+    /** effective limit of concurrent requests, 1 if running without threads */
+    int getMaxParallel() const { return m_maxParallel; }
+
+    /**
+     * Queue operation and start executing it as soon as a worker
+     * thread is available.
+     */
+    boost::shared_ptr<Pending> schedule(const Operation_t &operation);
+
+    /** true if operation has completed, successfully or with failure */
+    bool isDone(const boost::shared_ptr<Pending> &pending);
+
+    /**
+     * Wait for operation to complete, then rethrow its exception
+     * (if any) in the calling thread.
+     */
+    void check(const boost::shared_ptr<Pending> &pending);
+
+    /** wait for completion of all operations scheduled so far */
+    void finish();
+
+ private:
+    boost::shared_ptr<Settings> m_settings;
+    int m_maxParallel;
+
+#ifdef HAVE_THREAD_SUPPORT
+    struct Worker {
+        RequestScheduler *m_scheduler;
+        boost::shared_ptr<Session> m_session;
+        GThread *m_thread;
+    };
+    std::list< boost::shared_ptr<Worker> > m_workers;
+    WorkQueue<Pending> m_queue;
+
+    static gpointer workerThread(gpointer data);
+#endif
+
+    static void runOperation(Pending &pending, Session &session);
+};
+
 }
 SE_END_CXX
 
@@ -14,6 +14,7 @@
 
 #include <syncevo/LogRedirect.h>
 #include <syncevo/IdentityProvider.h>
+#include <syncevo/IniConfigNode.h>
 
 #include <boost/assign.hpp>
 
@@ -321,7 +322,8 @@ WebDAVSource::Props_t::iterator WebDAVSource::Props_t::find(const WebDAVSource::
 WebDAVSource::WebDAVSource(const SyncSourceParams &params,
                            const boost::shared_ptr<Neon::Settings> &settings) :
     TrackingSyncSource(params),
-    m_settings(settings)
+    m_settings(settings),
+    m_discoveryTTL(atoi(getEnv("SYNCEVOLUTION_WEBDAV_DISCOVERY_TTL", "86400")))
 {
     if (!m_settings) {
         m_contextSettings.reset(new ContextSettings(params.m_context, this));
@@ -622,6 +624,7 @@ void WebDAVSource::contactServer()
         SE_LOG_INFO(getDisplayName(), "using configured database=%s", database.c_str());
         // force authentication via username/password or OAuth2
         m_session->forceAuthorization(Neon::Session::AUTH_HTTPS, m_settings->getAuthProvider());
+        startScheduler();
         return;
     }
 
@@ -632,10 +635,16 @@ void WebDAVSource::contactServer()
     m_calendar = Neon::URI();
     SE_LOG_INFO(getDisplayName(), "determine final URL based on %s",
                 m_contextSettings ? m_contextSettings->getURLDescription().c_str() : "");
-    findCollections(boost::bind(setFirstURL,
-                                boost::ref(m_calendar),
-                                boost::ref(isReadOnly),
-                                _1, _2, _3));
+    try {
+        findCollections(boost::bind(setFirstURL,
+                                    boost::ref(m_calendar),
+                                    boost::ref(isReadOnly),
+                                    _1, _2, _3));
+    } catch (...) {
+        // DNS SRV result might be stale.
+        forgetDiscoveryCache();
+        throw;
+    }
     if (m_calendar.empty()) {
         throwError(SE_HERE, "no database found");
     }
@@ -679,6 +688,29 @@ void WebDAVSource::contactServer()
         }
     }
 #endif // HAVE_LIBNEON_OPTIONS
+
+    startScheduler();
+}
+
+void WebDAVSource::startScheduler()
+{
+    int maxParallel = atoi(getEnv("SYNCEVOLUTION_WEBDAV_CONNECTIONS", "1"));
+    if (maxParallel <= 0 ||
+        !parallelWritesSupported()) {
+        return;
+    }
+    boost::shared_ptr<AuthProvider> authProvider = m_settings->getAuthProvider();
+    if (authProvider &&
+        authProvider->methodIsSupported(AuthProvider::AUTH_METHOD_OAUTH2)) {
+        // Getting a token may depend on the main loop and thus
+        // cannot be done in a worker thread.
+        SE_LOG_DEBUG(getDisplayName(), "not running requests in the background because of OAuth2");
+        return;
+    }
+    m_scheduler.reset(new Neon::RequestScheduler(m_settings, maxParallel));
+    // Same session as before, but now settings are protected against
+    // concurrent access by the workers.
+    m_session = Neon::Session::create(m_scheduler->getSettings());
 }
 
 class Candidate {
@@ -735,9 +767,72 @@ public:
     }
 };
 
+ConfigNode *WebDAVSource::getDiscoveryCache()
+{
+    if (!m_discoveryCache) {
+        std::string dir = getCacheDir();
+        if (m_discoveryTTL <= 0 ||
+            dir.empty() ||
+            dir == "/dev/null") {
+            return NULL;
+        }
+        m_discoveryCache.reset(new IniHashConfigNode(dir, "webdav-discovery.ini", false));
+    }
+    return m_discoveryCache.get();
+}
+
+std::string WebDAVSource::readDiscoveryCache(const std::string &key)
+{
+    ConfigNode *cache = getDiscoveryCache();
+    if (!cache) {
+        return "";
+    }
+
+    // <time of discovery> <value>
+    std::string entry = cache->readProperty(key);
+    size_t pos = entry.find(' ');
+    if (pos == entry.npos) {
+        return "";
+    }
+    time_t stored = atol(entry.substr(0, pos).c_str());
+    time_t now = time(NULL);
+    if (stored > now ||
+        now - stored >= m_discoveryTTL) {
+        SE_LOG_DEBUG(getDisplayName(), "discovery cache: %s expired", key.c_str());
+        return "";
+    }
+    std::string value = entry.substr(pos + 1);
+    SE_LOG_DEBUG(getDisplayName(), "discovery cache: %s = %s", key.c_str(), value.c_str());
+    return value;
+}
+
+void WebDAVSource::writeDiscoveryCache(const std::string &key, const std::string &value)
+{
+    ConfigNode *cache = getDiscoveryCache();
+    if (cache) {
+        cache->writeProperty(key, StringPrintf("%ld %s", (long)time(NULL), value.c_str()));
+        cache->flush();
+    }
+}
+
+void WebDAVSource::forgetDiscoveryCache()
+{
+    ConfigNode *cache = getDiscoveryCache();
+    if (cache) {
+        SE_LOG_DEBUG(getDisplayName(), "discovery cache: forget everything");
+        cache->clear();
+        cache->flush();
+    }
+}
+
 std::string WebDAVSource::lookupDNSSRV(const std::string &domain)
 {
-    std::string url;
+    std::string key = "srv-" + domain;
+    std::string url = readDiscoveryCache(key);
+    if (!url.empty()) {
+        return url;
+    }
+
     int timeoutSeconds = m_settings->timeoutSeconds();
     int retrySeconds = m_settings->retrySeconds();
 
@@ -772,6 +867,7 @@ std::string WebDAVSource::lookupDNSSRV(const std::string &domain)
         switch (res) {
         case 0:
             SE_LOG_DEBUG(getDisplayName(), "found syncURL '%s' via DNS SRV", buffer);
+            writeDiscoveryCache(key, url);
             break;
         case 2:
             throwError(SE_HERE, StringPrintf("syncevo-webdav-lookup did not find a DNS utility to search for %s in %s", serviceType().c_str(), domain.c_str()));
@@ -1685,6 +1781,7 @@ bool WebDAVSource::isUsable()
 
 void WebDAVSource::close()
 {
+    m_scheduler.reset();
     m_session.reset();
 }
 
@@ -1962,7 +2059,8 @@ void WebDAVSource::listAllItems(RevisionMap_t &revisions)
     }
 }
 
-std::string WebDAVSource::findByUID(const std::string &uid,
+std::string WebDAVSource::findByUID(Neon::Session &session,
+                                    const std::string &uid,
                                     const Timespec &deadline)
 {
     RevisionMap_t revisions;
@@ -2007,13 +2105,13 @@ std::string WebDAVSource::findByUID(const std::string &uid,
             "</C:filter>\n"
             "</C:calendar-query>\n";
     }
-    getSession()->startOperation("REPORT 'UID lookup'", deadline);
+    session.startOperation("REPORT 'UID lookup'", deadline);
     while (true) {
         Neon::XMLParser parser;
         parser.initReportParser(boost::bind(&WebDAVSource::checkItem, this,
                                             boost::ref(revisions),
                                             _1, _2, (std::string *)0));
-        Neon::Request report(*getSession(), "REPORT", getCalendar().m_path, query, parser);
+        Neon::Request report(session, "REPORT", getCalendar().m_path, query, parser);
         report.addHeader("Depth", "1");
         report.addHeader("Content-Type", "application/xml; charset=\"utf-8\"");
         if (report.run()) {
@@ -2134,6 +2232,9 @@ std::string WebDAVSource::luid2path(const std::string &luid)
 
 void WebDAVSource::readItem(const string &uid, std::string &item, bool raw)
 {
+    // Must see the result of pending writes done in the background.
+    finishItemChanges();
+
     Timespec deadline = createDeadline();
     m_session->startOperation("GET", deadline);
     while (true) {
@@ -2160,6 +2261,105 @@ void WebDAVSource::readItem(const string &uid, std::string &item, bool raw)
 }
 
 TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid, const std::string &item, bool raw)
+{
+    std::string revision = uid.empty() ? "" : expectedRevision(uid);
+    if (!m_scheduler) {
+        return storeResource(*m_session, uid, item, revision);
+    }
+
+    // Must be done in the main thread, storeResource() then
+    // only reads m_postPath.
+    if (uid.empty()) {
+        checkPostSupport();
+    }
+    boost::shared_ptr<InsertItemResult> result(new InsertItemResult);
+    boost::shared_ptr<Neon::RequestScheduler::Pending> pending =
+        m_scheduler->schedule(boost::bind(&WebDAVSource::storeResourceAsync,
+                                          this, _1, uid, item, revision, result));
+    return checkInsert(pending, result);
+}
+
+void WebDAVSource::storeResourceAsync(Neon::Session &session,
+                                      const std::string &luid,
+                                      const std::string &item,
+                                      const std::string &revision,
+                                      const boost::shared_ptr<InsertItemResult> &result)
+{
+    *result = storeResource(session, luid, item, revision);
+}
+
+TrackingSyncSource::InsertItemResult WebDAVSource::checkInsert(const boost::shared_ptr<Neon::RequestScheduler::Pending> &pending,
+                                                               const boost::shared_ptr<InsertItemResult> &result)
+{
+    if (!m_scheduler->isDone(pending)) {
+        return InsertItemResult(boost::bind(&WebDAVSource::checkInsert, this, pending, result));
+    }
+    m_scheduler->check(pending);
+    return *result;
+}
+
+bool WebDAVSource::checkRemove(const boost::shared_ptr<Neon::RequestScheduler::Pending> &pending)
+{
+    if (!m_scheduler->isDone(pending)) {
+        return false;
+    }
+    m_scheduler->check(pending);
+    return true;
+}
+
+std::string WebDAVSource::expectedRevision(const std::string &luid)
+{
+    return getTrackingNode().readProperty(luid);
+}
+
+bool WebDAVSource::checkPrecondition(Neon::Session &session,
+                                     const std::string &luid,
+                                     const std::string &revision,
+                                     const Timespec &deadline)
+{
+    RevisionMap_t revisions;
+    bool failed = false;
+    try {
+        session.propfindURI(luid2path(luid), 0, getetag,
+                            boost::bind(&WebDAVSource::listAllItemsCallback,
+                                        this, _1, _2, boost::ref(revisions),
+                                        boost::ref(failed)),
+                            deadline);
+    } catch (const TransportStatusException &ex) {
+        if (ex.syncMLStatus() != STATUS_NOT_FOUND) {
+            throw;
+        }
+        SE_THROW_EXCEPTION_STATUS(TransportStatusException,
+                                  "object not found (was 412 'Precondition Failed')",
+                                  STATUS_NOT_FOUND);
+    }
+    const std::string &current = revisions[luid];
+    if (failed || current.empty()) {
+        SE_THROW("could not retrieve ETag");
+    }
+    if (current == revision) {
+        SE_LOG_DEBUG(NULL, "%s: 412 'Precondition Failed' although revision %s matches, ignoring precondition",
+                     luid.c_str(), revision.c_str());
+        return true;
+    }
+    SE_THROW_EXCEPTION_STATUS(TransportStatusException,
+                              StringPrintf("%s: modified concurrently on server, revision %s instead of %s",
+                                           luid.c_str(), current.c_str(), revision.c_str()),
+                              SyncMLStatus(409));
+    return false;
+}
+
+void WebDAVSource::finishItemChanges()
+{
+    if (m_scheduler) {
+        m_scheduler->finish();
+    }
+}
+
+TrackingSyncSource::InsertItemResult WebDAVSource::storeResource(Neon::Session &session,
+                                                                 const std::string &uid,
+                                                                 const std::string &item,
+                                                                 const std::string &revision)
 {
     std::string new_uid;
     std::string rev;
@@ -2178,9 +2378,10 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
         }
     }
     Timespec deadline = createDeadline(); // no resending if left empty
-    m_session->startOperation(operation, deadline);
+    session.startOperation(operation, deadline);
     std::string result;
     int counter = 0;
+    bool ifMatch = !revision.empty();
  retry:
     counter++;
     result = "";
@@ -2189,7 +2390,7 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
         // catch unexpected conflicts via If-None-Match: *.
         std::string buffer;
         const std::string *data = createResourceName(item, buffer, new_uid);
-        Neon::Request req(*m_session, operation,
+        Neon::Request req(session, operation,
                           operation == postOperation ? m_postPath : luid2path(new_uid),
                           *data, result);
         // Clearing the idempotent flag would allow us to clearly
@@ -2247,7 +2448,7 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
                 try {
                     std::string uid = extractUID(item);
                     if (!uid.empty()) {
-                        std::string luid = findByUID(uid, deadline);
+                        std::string luid = findByUID(session, uid, deadline);
                         return InsertItemResult(luid, "", ITEM_NEEDS_MERGE);
                     }
                 } catch (...) {
@@ -2266,7 +2467,7 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
             // with the same UID. Go find it, so that we can report back the
             // right luid.
             std::string uid = extractUID(item);
-            std::string luid = findByUID(uid, deadline);
+            std::string luid = findByUID(session, uid, deadline);
             return InsertItemResult(luid, "", ITEM_NEEDS_MERGE);
             break;
         }
@@ -2305,11 +2506,11 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
             // was created.
             RevisionMap_t revisions;
             bool failed = false;
-            m_session->propfindURI(luid2path(new_uid), 0, getetag,
-                                   boost::bind(&WebDAVSource::listAllItemsCallback,
-                                               this, _1, _2, boost::ref(revisions),
-                                               boost::ref(failed)),
-                                   deadline);
+            session.propfindURI(luid2path(new_uid), 0, getetag,
+                                boost::bind(&WebDAVSource::listAllItemsCallback,
+                                            this, _1, _2, boost::ref(revisions),
+                                            boost::ref(failed)),
+                                deadline);
             // Turns out we get a result for our original path even in
             // the case of a merge, although the original path is not
             // listed when looking at the collection.  Let's use that
@@ -2328,26 +2529,43 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
         new_uid = uid;
         std::string buffer;
         const std::string *data = setResourceName(item, buffer, new_uid);
-        Neon::Request req(*m_session, "PUT", luid2path(new_uid),
+        Neon::Request req(session, "PUT", luid2path(new_uid),
                           *data, result);
         // See above for discussion of idempotent and PUT.
         // req.setFlag(NE_REQFLAG_IDEMPOTENT, 0);
         req.addHeader("Content-Type", contentType());
-        // TODO: match exactly the expected revision, aka ETag,
-        // or implement locking. Note that the ETag might not be
-        // known, for example in this case:
+        // Match exactly the expected revision, aka ETag. Note that
+        // the ETag might not be known, for example in this case:
         // - PUT succeeds
         // - PROPGET does not
         // - insertItem() fails
         // - Is retried? Might need slow sync in this case!
         //
-        // req.addHeader("If-Match", etag);
-        if (!req.run()) {
+        // When resending, our own first attempt might already have
+        // changed the ETag, so only check in the first attempt.
+        if (ifMatch && counter == 1) {
+            req.addHeader("If-Match", "\"" + revision + "\"");
+        }
+        static const std::set<int> expected = boost::assign::list_of(412);
+        if (!req.run(&expected)) {
             goto retry;
         }
         SE_LOG_DEBUG(NULL, "update item status: %s",
                      Neon::Status2String(req.getStatus()).c_str());
         switch (req.getStatusCode()) {
+        case 412:
+            if (!ifMatch || counter != 1) {
+                SE_THROW_EXCEPTION_STATUS(TransportStatusException,
+                                          std::string("unexpected status for update: ") +
+                                          Neon::Status2String(req.getStatus()),
+                                          SyncMLStatus(req.getStatus()->code));
+            }
+            // throws an error if the item really was modified
+            checkPrecondition(session, new_uid, revision, deadline);
+            ifMatch = false;
+            session.startOperation(operation, deadline);
+            goto retry;
+            break;
         case 204:
             // the expected outcome, as we were asking for an overwrite
             break;
@@ -2378,11 +2596,11 @@ TrackingSyncSource::InsertItemResult WebDAVSource::insertItem(const string &uid,
         // so any kind of caching of ETag would not work either.
         bool failed = false;
         RevisionMap_t revisions;
-        m_session->propfindURI(luid2path(new_uid), 0, getetag,
-                               boost::bind(&WebDAVSource::listAllItemsCallback,
-                                           this, _1, _2, boost::ref(revisions),
-                                           boost::ref(failed)),
-                               deadline);
+        session.propfindURI(luid2path(new_uid), 0, getetag,
+                            boost::bind(&WebDAVSource::listAllItemsCallback,
+                                        this, _1, _2, boost::ref(revisions),
+                                        boost::ref(failed)),
+                            deadline);
         rev = revisions[new_uid];
         if (failed || rev.empty()) {
             SE_THROW("could not retrieve ETag");
@@ -2438,8 +2656,10 @@ bool WebDAVSource::isLeafCollection(const StringMap &props) const
 
 Timespec WebDAVSource::createDeadline() const
 {
-    int timeoutSeconds = m_settings->timeoutSeconds();
-    int retrySeconds = m_settings->retrySeconds();
+    // Also called by storeResource() in worker threads.
+    const Neon::Settings &settings = m_scheduler ? *m_scheduler->getSettings() : *m_settings;
+    int timeoutSeconds = settings.timeoutSeconds();
+    int retrySeconds = settings.retrySeconds();
     if (timeoutSeconds > 0 &&
         retrySeconds > 0) {
         return Timespec::monotonic() + timeoutSeconds;
@@ -2449,19 +2669,52 @@ Timespec WebDAVSource::createDeadline() const
 }
 
 void WebDAVSource::removeItem(const string &uid)
+{
+    removeResource(*m_session, uid, expectedRevision(uid));
+}
+
+SyncSourceDelete::DeleteItemCheck_t WebDAVSource::removeItemAsync(const string &uid)
+{
+    if (!m_scheduler) {
+        removeItem(uid);
+        return DeleteItemCheck_t();
+    }
+
+    boost::shared_ptr<Neon::RequestScheduler::Pending> pending =
+        m_scheduler->schedule(boost::bind(&WebDAVSource::removeResource,
+                                          this, _1, uid, expectedRevision(uid)));
+    return DeleteItemCheck_t(boost::bind(&WebDAVSource::checkRemove, this, pending));
+}
+
+void WebDAVSource::removeResource(Neon::Session &session,
+                                  const std::string &uid,
+                                  const std::string &revision)
 {
     Timespec deadline = createDeadline();
-    m_session->startOperation("DELETE", deadline);
+    session.startOperation("DELETE", deadline);
     std::string item, result;
     boost::scoped_ptr<Neon::Request> req;
+    int counter = 0;
+    bool ifMatch = !revision.empty();
     while (true) {
-        req.reset(new Neon::Request(*m_session, "DELETE", luid2path(uid),
+        counter++;
+        req.reset(new Neon::Request(session, "DELETE", luid2path(uid),
                                     item, result));
-        // TODO: match exactly the expected revision, aka ETag,
-        // or implement locking.
-        // req.addHeader("If-Match", etag);
+        // Match exactly the expected revision, aka ETag, but only in
+        // the first attempt (see storeResource()).
+        if (ifMatch && counter == 1) {
+            req->addHeader("If-Match", "\"" + revision + "\"");
+        }
         static const std::set<int> expected = boost::assign::list_of(412);
         if (req->run(&expected)) {
+            if (req->getStatusCode() == 412 &&
+                ifMatch && counter == 1) {
+                // throws an error if the item is gone or was modified
+                checkPrecondition(session, uid, revision, deadline);
+                ifMatch = false;
+                session.startOperation("DELETE", deadline);
+                continue;
+            }
             break;
         }
     }
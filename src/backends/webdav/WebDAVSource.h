@@ -92,6 +92,7 @@ class WebDAVSource : public TrackingSyncSource, private boost::noncopyable
     }
     /** hook into session to store infos */
     virtual std::string endSync(bool success) {
+        finishItemChanges();
         if (success) {
              storeServerInfos();
 	}
@@ -107,6 +108,51 @@ class WebDAVSource : public TrackingSyncSource, private boost::noncopyable
     virtual InsertItemResult insertItem(const string &luid, const std::string &item, bool raw);
     void readItem(const std::string &luid, std::string &item, bool raw);
     virtual void removeItem(const string &uid);
+    virtual DeleteItemCheck_t removeItemAsync(const string &uid);
+
+    /* waiting for item changes which run in the background, see m_scheduler */
+    virtual void finishItemChanges();
+
+    /**
+     * True if insertItem() and removeItem() may return before the
+     * change is done on the server, with the result delivered via
+     * InsertItemResult resp. DeleteItemCheck_t continuations.
+     * Only works for sources which pass the result on to
+     * TrackingSyncSource, therefore derived classes which need the
+     * result of insertItem() immediately must return false.
+     */
+    virtual bool parallelWritesSupported() const { return true; }
+
+    /**
+     * The revision that the item on the server is expected to have
+     * when updating or deleting it. Sent as If-Match precondition,
+     * so that changes made by someone else since the last sync are
+     * not overwritten silently. Empty if unknown, which disables the
+     * check.
+     *
+     * The default implementation returns the revision recorded by
+     * change tracking.
+     */
+    virtual std::string expectedRevision(const std::string &luid);
+
+    /**
+     * Synchronous implementation of insertItem(), using the given
+     * session. Safe to call in a worker thread of m_scheduler.
+     *
+     * @param revision    see expectedRevision(), only used for updates
+     */
+    InsertItemResult storeResource(Neon::Session &session,
+                                   const std::string &luid,
+                                   const std::string &item,
+                                   const std::string &revision);
+
+    /**
+     * Synchronous implementation of removeItem(), same
+     * parameters as storeResource().
+     */
+    void removeResource(Neon::Session &session,
+                        const std::string &luid,
+                        const std::string &revision);
 
     /**
      * A resource path is turned into a locally unique ID by
@@ -208,7 +254,8 @@ class WebDAVSource : public TrackingSyncSource, private boost::noncopyable
      * Find one item by its UID property value and return the corresponding
      * resource name relative to the current collection (aka luid).
      */
-    std::string findByUID(const std::string &uid, const Timespec &deadline);
+    std::string findByUID(const std::string &uid, const Timespec &deadline) { return findByUID(*m_session, uid, deadline); }
+    std::string findByUID(Neon::Session &session, const std::string &uid, const Timespec &deadline);
 
     /**
      * Get UID property value from vCard 3.0 or iCalendar 2.0 text
@@ -235,9 +282,63 @@ class WebDAVSource : public TrackingSyncSource, private boost::noncopyable
     boost::shared_ptr<ContextSettings> m_contextSettings;
     boost::shared_ptr<Neon::Session> m_session;
 
+    /**
+     * Runs item changes in the background, each worker with its
+     * own connection. Not set when disabled via
+     * SYNCEVOLUTION_WEBDAV_CONNECTIONS=0, see startScheduler().
+     */
+    boost::shared_ptr<Neon::RequestScheduler> m_scheduler;
+
+    /** called by contactServer() once m_session is ready */
+    void startScheduler();
+
+    void storeResourceAsync(Neon::Session &session,
+                            const std::string &luid,
+                            const std::string &item,
+                            const std::string &revision,
+                            const boost::shared_ptr<InsertItemResult> &result);
+    InsertItemResult checkInsert(const boost::shared_ptr<Neon::RequestScheduler::Pending> &pending,
+                                 const boost::shared_ptr<InsertItemResult> &result);
+    bool checkRemove(const boost::shared_ptr<Neon::RequestScheduler::Pending> &pending);
+
+    /**
+     * Called after the server rejected a write with 412 "Precondition
+     * Failed" although the If-Match revision was taken from change
+     * tracking. Returns true if the item still has that revision
+     * (server does not support the precondition, for example because
+     * of weak ETags), in which case the caller may write
+     * unconditionally. Otherwise throws a 404 if the item is gone
+     * or a 409 "Conflict" if it was modified concurrently.
+     */
+    bool checkPrecondition(Neon::Session &session,
+                           const std::string &luid,
+                           const std::string &revision,
+                           const Timespec &deadline);
+
     /** normalized path: including backslash, URI encoded */
     Neon::URI m_calendar;
 
+    /**
+     * Results of DNS SRV lookups, kept across syncs in the cache
+     * dir of the source. The collection itself does not need to be
+     * cached, storeServerInfos() saves it as database ID. Entries
+     * expire after SYNCEVOLUTION_WEBDAV_DISCOVERY_TTL seconds and
+     * are dropped when the collection search fails. See
+     * getDiscoveryCache().
+     */
+    boost::shared_ptr<ConfigNode> m_discoveryCache;
+    int m_discoveryTTL;
+
+    /** NULL if caching is disabled or not possible */
+    ConfigNode *getDiscoveryCache();
+
+    /** cached value, empty if not found or expired */
+    std::string readDiscoveryCache(const std::string &key);
+    void writeDiscoveryCache(const std::string &key, const std::string &value);
+
+    /** drop all cached results, to be called when using them failed */
+    void forgetDiscoveryCache();
+
     /**
      * Unset until checkPostSupport() is called,
      * valid path for POST if server supports RFC 5995,
@@ -456,6 +456,15 @@ private:
             return "eds_event,eds_task";
         } else if (configName == "file_calendar+todo") {
             return "file_event,file_task";
+        } else if (boost::starts_with(configName, "file_sharded_")) {
+            // same directory as for the other file sources,
+            // but with the sharded layout
+            const string filePrefix("file://");
+            string prefix = m_evoPrefix;
+            if (boost::starts_with(prefix, filePrefix)) {
+                prefix = prefix.substr(filePrefix.size());
+            }
+            return "sharded://" + prefix + configName + "_" + m_clientID;
         }
         return m_evoPrefix + configName + "_" + m_clientID;
     }
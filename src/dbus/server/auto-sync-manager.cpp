@@ -28,11 +28,20 @@
 
 #include <boost/tokenizer.hpp>
 
+#include <algorithm>
+
 SE_BEGIN_CXX
 
+/**
+ * Upper limit in seconds for the delay between retries of syncing
+ * local changes when the config has no auto sync interval.
+ */
+static const unsigned int AUTOSYNC_MAX_RETRY_DELAY = 3600;
+
 AutoSyncManager::AutoSyncManager(Server &server) :
     m_server(server),
-    m_autoTermLocked(false)
+    m_autoTermLocked(false),
+    m_changeDelay(atoi(getEnv("SYNCEVOLUTION_AUTOSYNC_CHANGE_DELAY", "10")))
 {
 }
 
@@ -207,9 +216,12 @@ void AutoSyncManager::initConfig(const std::string &configName)
                              url.c_str());
             }
         }
+
+        monitorDatabases(*task, config);
     } else {
         // Just clear urls, which disables auto syncing.
         task->m_urls.clear();
+        task->m_monitors.clear();
     }
 
     bool lock = preventTerm();
@@ -227,6 +239,145 @@ void AutoSyncManager::initConfig(const std::string &configName)
     schedule("initConfig() for " + configName);
 }
 
+void AutoSyncManager::monitorDatabases(AutoSyncTask &task, SyncConfig &config)
+{
+    task.m_monitors.clear();
+    if (!m_changeDelay ||
+        task.m_urls.empty()) {
+        return;
+    }
+
+    // Directories which contain the databases, for backends where
+    // that is known.
+    std::list<std::string> dirs;
+    BOOST_FOREACH (const std::string &sourceName, config.getSyncSources()) {
+        SyncSourceNodes nodes = config.getSyncSourceNodesNoTracking(sourceName);
+        SyncSourceConfig source(sourceName, nodes);
+        std::string sync = source.getSync();
+        if (sync == "disabled" || sync == "none") {
+            continue;
+        }
+        std::string backend = source.getSourceType().m_backend;
+        std::string database = source.getDatabaseID();
+        if (backend == "file") {
+            // The backend's database name is [file://|sharded://]<path>.
+            // Sharded directories have items in sub-directories, which
+            // must be watched separately.
+            bool sharded = false;
+            if (boost::starts_with(database, "file://")) {
+                database = database.substr(strlen("file://"));
+            } else if (boost::starts_with(database, "sharded://")) {
+                database = database.substr(strlen("sharded://"));
+                sharded = true;
+            }
+            dirs.push_back(database);
+            if (sharded) {
+                BOOST_FOREACH (const std::string &entry, ReadDir(database, false)) {
+                    if (entry.size() == 2) {
+                        dirs.push_back(database + "/" + entry);
+                    }
+                }
+            }
+        } else {
+            // Evolution Data Server stores each database in its own
+            // directory, named after the UID of the database.
+            static const char * const edsBackends[][2] = {
+                { "Evolution Address Book", "addressbook" },
+                { "Evolution Calendar", "calendar" },
+                { "Evolution Task List", "tasks" },
+                { "Evolution Memos", "memos" }
+            };
+            for (size_t i = 0; i < sizeof(edsBackends) / sizeof(edsBackends[0]); i++) {
+                if (backend == edsBackends[i][0]) {
+                    dirs.push_back(StringPrintf("%s/evolution/%s/%s",
+                                                g_get_user_data_dir(),
+                                                edsBackends[i][1],
+                                                database.empty() ? "system" : database.c_str()));
+                    break;
+                }
+            }
+        }
+    }
+
+    BOOST_FOREACH (const std::string &dir, dirs) {
+        if (!isDir(dir)) {
+            SE_LOG_DEBUG(NULL, "auto sync: %s: cannot watch %s, not a directory",
+                         task.m_configName.c_str(),
+                         dir.c_str());
+            continue;
+        }
+        try {
+            SE_LOG_DEBUG(NULL, "auto sync: %s: watching %s for local changes",
+                         task.m_configName.c_str(),
+                         dir.c_str());
+            boost::shared_ptr<GLibNotify> monitor(new GLibNotify(dir.c_str(),
+                                                                 boost::bind(&AutoSyncManager::localChange,
+                                                                             this,
+                                                                             task.m_configName,
+                                                                             dir),
+                                                                 true));
+            task.m_monitors.push_back(monitor);
+        } catch (...) {
+            // ignore errors for individual directories, the
+            // interval still triggers syncs
+            Exception::handle();
+        }
+    }
+}
+
+void AutoSyncManager::localChange(const std::string &configName, const std::string &path)
+{
+    PeerMap::iterator it = m_peerMap.find(configName);
+    if (it == m_peerMap.end()) {
+        return;
+    }
+    AutoSyncTask &task = *it->second;
+    Timespec now = Timespec::monotonic();
+
+    // Our own sync modifies the databases. Some file monitoring
+    // events arrive with a delay, so also ignore those which come
+    // shortly after the sync.
+    if (task.m_syncing ||
+        (task.m_syncEndTime && task.m_syncEndTime + 2 > now)) {
+        SE_LOG_DEBUG(NULL, "auto sync: %s: ignore change in %s caused by sync",
+                     configName.c_str(),
+                     path.c_str());
+        return;
+    }
+
+    if (!task.m_localChangeTime) {
+        SE_LOG_DEBUG(NULL, "auto sync: %s: local change in %s, sync in %us unless more changes follow",
+                     configName.c_str(),
+                     path.c_str(),
+                     m_changeDelay);
+        task.m_localChangeTime = now;
+    }
+    task.m_lastLocalChangeTime = now;
+
+    // Debounce: each change delays the sync until there are no
+    // further changes for a while.
+    armChangeTimeout(task);
+}
+
+Timespec AutoSyncManager::changesDue(const AutoSyncTask &task) const
+{
+    return std::max(std::min(task.m_lastLocalChangeTime + m_changeDelay,
+                             task.m_localChangeTime + 10 * m_changeDelay),
+                    task.m_retryTime);
+}
+
+void AutoSyncManager::armChangeTimeout(AutoSyncTask &task)
+{
+    Timespec now = Timespec::monotonic();
+    Timespec deadline = changesDue(task);
+    // Adds one second, like the other timers, to not wake up too soon.
+    int seconds = (deadline > now ? (deadline - now).seconds() : 0) + 1;
+    task.m_changeTimeout.runOnce(seconds,
+                                 boost::bind(&AutoSyncManager::schedule,
+                                             this,
+                                             task.m_configName + " local change"));
+}
+
 void AutoSyncManager::schedule(const std::string &reason)
 {
     SE_LOG_DEBUG(NULL, "auto sync: reschedule, %s", reason.c_str());
@@ -253,12 +404,22 @@ void AutoSyncManager::schedule(const std::string &reason)
         const std::string &configName = entry.first;
         const boost::shared_ptr<AutoSyncTask> &task = entry.second;
 
-        if (task->m_interval <= 0 || // not enabled
-            task->m_permanentFailure) { // don't try again
+        if (task->m_permanentFailure) { // don't try again
             continue;
         }
 
-        if (task->m_lastSyncTime + task->m_interval > now) {
+        // Local changes are ready to be synced once no further
+        // changes happened for a while, or after waiting long
+        // enough despite ongoing changes.
+        bool changed = task->m_localChangeTime &&
+            changesDue(*task) <= now;
+        if (changed) {
+            SE_LOG_DEBUG(NULL, "auto sync: %s: local changes need to be synced",
+                         configName.c_str());
+        } else if (task->m_interval <= 0) {
+            // Not enabled or only syncing local changes.
+            continue;
+        } else if (task->m_lastSyncTime + task->m_interval > now) {
             // Ran too recently, check again in the future. Always
             // reset timer, because both m_lastSyncTime and m_interval
             // may have changed.
@@ -411,6 +572,12 @@ void AutoSyncManager::sessionStarted(const boost::shared_ptr<Session> &session)
     const boost::shared_ptr<AutoSyncTask> &task = it->second;
     task->m_lastSyncTime = Timespec::monotonic();
 
+    // The sync includes all local changes made so far. They are
+    // only considered synced once the sync succeeds, see
+    // anySyncDone().
+    task->m_syncing = true;
+    task->m_changeTimeout.deactivate();
+
     // track permanent failure
     session->m_doneSignal.connect(Session::DoneSignal_t::slot_type(&AutoSyncManager::anySyncDone, this, task.get(), _1).track(task).track(me));
 
@@ -432,7 +599,7 @@ bool AutoSyncManager::preventTerm()
 {
     BOOST_FOREACH (const PeerMap::value_type &entry, m_peerMap) {
         const boost::shared_ptr<AutoSyncTask> &task = entry.second;
-        if (task->m_interval > 0 &&
+        if ((task->m_interval > 0 || !task->m_monitors.empty()) &&
             !task->m_permanentFailure &&
             !task->m_urls.empty()) {
             // that task might run
@@ -507,6 +674,9 @@ void AutoSyncManager::autoSyncDone(AutoSyncTask *task, SyncMLStatus status)
 
 void AutoSyncManager::anySyncDone(AutoSyncTask *task, SyncMLStatus status)
 {
+    task->m_syncing = false;
+    task->m_syncEndTime = Timespec::monotonic();
+
     // set "permanently failed" flag according to most recent result
     task->m_permanentFailure = status != STATUS_OK && !ErrorIsTemporary(status);
     SE_LOG_DEBUG(NULL, "auto sync: sync session %s done, result %d %s",
@@ -517,6 +687,25 @@ void AutoSyncManager::anySyncDone(AutoSyncTask *task, SyncMLStatus status)
                  status == STATUS_OK ?
                  "is success" :
                  "is temporary failure");
+
+    if (status == STATUS_OK) {
+        task->m_localChangeTime = Timespec();
+        task->m_retryDelay = 0;
+        task->m_retryTime = Timespec();
+    } else if (task->m_localChangeTime) {
+        // Try again later, otherwise the changes would not get synced
+        // at all without an auto sync interval. Back off while the
+        // peer keeps failing, up to the auto sync interval.
+        unsigned int maxDelay = task->m_interval > 0 ? task->m_interval : AUTOSYNC_MAX_RETRY_DELAY;
+        task->m_retryDelay = task->m_retryDelay ?
+            std::min(task->m_retryDelay * 2, maxDelay) :
+            std::min(std::max(m_changeDelay, 1u), maxDelay);
+        task->m_retryTime = task->m_syncEndTime + task->m_retryDelay;
+        SE_LOG_DEBUG(NULL, "auto sync: %s: retry local changes in %us",
+                     task->m_configName.c_str(),
+                     task->m_retryDelay);
+        armChangeTimeout(*task);
+    }
 }
 
 SE_END_CXX
@@ -30,6 +30,7 @@
 #include <syncevo/SmartPtr.h>
 #include <syncevo/util.h>
 #include <syncevo/timeout.h>
+#include <syncevo/GLibSupport.h>
 
 #include "notification-manager-factory.h"
 
@@ -51,9 +52,10 @@ class Session;
  * parallel sessions are not currently supported by SyncEvolution,
  * scheduling the next session waits until the server is idle again.
  *
- * Currently only time-based automatic syncs are supported.
- * Syncs triggered by local or remote changes will be added
- * later.
+ * Automatic syncs are time-based. In addition, local databases
+ * which can be watched via file monitoring (file backend, Evolution
+ * Data Server) trigger a sync shortly after they were modified
+ * locally. Syncs triggered by remote changes are not supported.
  */
 class AutoSyncManager
 {
@@ -72,6 +74,13 @@ class AutoSyncManager
     /** time when Bluetooth and HTTP transports became available, zero if not available */
     Timespec m_btStartTime, m_httpStartTime;
 
+    /**
+     * seconds without further local changes before syncing them,
+     * zero disables watching local databases
+     * (SYNCEVOLUTION_AUTOSYNC_CHANGE_DELAY)
+     */
+    unsigned int m_changeDelay;
+
     /** initialize m_idleConnection */
     void connectIdle();
 
@@ -144,12 +153,42 @@ class AutoSyncManager
         typedef std::list< std::pair<Transport, std::string> > URLInfo_t;
         URLInfo_t m_urls;
 
+        /**
+         * time of the oldest local change not included in a
+         * successful sync yet, zero if none
+         */
+        Timespec m_localChangeTime;
+
+        /** time of the most recent local change */
+        Timespec m_lastLocalChangeTime;
+
+        /**
+         * seconds to wait before retrying local changes after the
+         * last sync failed, doubled after each consecutive failure,
+         * zero after a successful sync
+         */
+        unsigned int m_retryDelay;
+
+        /** local changes are not synced again before this time */
+        Timespec m_retryTime;
+
+        /** true while a sync session for the config is running */
+        bool m_syncing;
+
+        /** end of the last sync session, changes shortly after it are from the sync itself */
+        Timespec m_syncEndTime;
+
+        /** watch the local databases used by the config */
+        std::list< boost::shared_ptr<GLibNotify> > m_monitors;
+
         AutoSyncTask(const std::string &configName) :
             m_configName(configName),
             m_syncSuccessStart(false),
             m_permanentFailure(false),
             m_delay(0),
-            m_interval(0)
+            m_interval(0),
+            m_retryDelay(0),
+            m_syncing(false)
         {
         }
 
@@ -162,6 +201,7 @@ class AutoSyncManager
         Timeout m_intervalTimeout;
         Timeout m_btTimeout;
         Timeout m_httpTimeout;
+        Timeout m_changeTimeout;
     };
 
     /* /\** remove tasks from m_peerMap and m_workQueue created from the config *\/ */
@@ -208,6 +248,23 @@ class AutoSyncManager
     /** Record result. */
     void anySyncDone(AutoSyncTask *task, SyncMLStatus status);
 
+    /** (re)create m_monitors of the task */
+    void monitorDatabases(AutoSyncTask &task, SyncConfig &config);
+
+    /** called by m_monitors, schedules a sync after m_changeDelay */
+    void localChange(const std::string &configName, const std::string &path);
+
+    /**
+     * Time when the pending local changes of the task are ready to
+     * be synced: m_changeDelay after the last change, but not later
+     * than 10 * m_changeDelay after the first one, and not before
+     * AutoSyncTask::m_retryTime.
+     */
+    Timespec changesDue(const AutoSyncTask &task) const;
+
+    /** run schedule() at changesDue() */
+    void armChangeTimeout(AutoSyncTask &task);
+
     AutoSyncManager(Server &server);
 
  public:
@@ -104,13 +104,13 @@ static bool IsSyncML(const std::string &messageType)
 
 
 void Connection::process(const Caller_t &caller,
-                         const GDBusCXX::DBusArray<uint8_t> &message,
+                         const SharedBuffer &message,
                          const std::string &message_type)
 {
     SE_LOG_DEBUG(NULL, "Connection %s: D-Bus client %s sends %lu bytes, %s (old state %s)",
                  m_sessionID.c_str(),
                  caller.c_str(),
-                 (unsigned long)message.first,
+                 (unsigned long)message.size(),
                  message_type.c_str(),
                  SessionCommon::ConnectionStateToString(m_state).c_str());
 
@@ -137,12 +137,11 @@ void Connection::process(const Caller_t &caller,
             // as client or server, choose config
             if (message_type == "HTTP Config") {
                 // type used for testing, payload is config name
-                config.assign(reinterpret_cast<const char *>(message.second),
-                              message.first);
+                config.assign(message.get(), message.size());
             } else if (message_type == TransportAgent::m_contentTypeServerAlertedNotificationDS) {
                 serverAlerted = true;
                 sysync::SanPackage san;
-                if (san.PassSan(const_cast<uint8_t *>(message.second), message.first, 2) || san.GetHeader()) {
+                if (san.PassSan(reinterpret_cast<uint8_t *>(message.get()), message.size(), 2) || san.GetHeader()) {
                     // We are very tolerant regarding the content of the message.
                     // If it doesn't parse, try to do something useful anyway.
                     // only for SAN 1.2, for SAN 1.0/1.1 we can not be sure
@@ -264,8 +263,8 @@ void Connection::process(const Caller_t &caller,
                 // peek into the data to extract the locURI = device ID,
                 // then use it to find the configuration
                 SyncContext::SyncMLMessageInfo info;
-                info = SyncContext::analyzeSyncMLMessage(reinterpret_cast<const char *>(message.second),
-                                                         message.first,
+                info = SyncContext::analyzeSyncMLMessage(message.get(),
+                                                         message.size(),
                                                          message_type);
                 if (info.m_deviceID.empty()) {
                     // TODO: proper exception
@@ -305,9 +304,7 @@ void Connection::process(const Caller_t &caller,
                                                m_sessionID);
             m_session->activate();
             if (serverMode) {
-                m_session->initServer(SharedBuffer(reinterpret_cast<const char *>(message.second),
-                                                   message.first),
-                                      message_type);
+                m_session->initServer(message, message_type);
             }
             m_session->setServerAlerted(serverAlerted);
             m_session->setPriority(Session::PRI_CONNECTION);
@@ -342,8 +339,7 @@ void Connection::process(const Caller_t &caller,
             SE_THROW("protocol error: already processing a message");
             break;
         case SessionCommon::WAITING:
-            m_incomingMsg = SharedBuffer(reinterpret_cast<const char *>(message.second),
-                                         message.first);
+            m_incomingMsg = message;
             m_incomingMsgType = message_type;
             m_messageSignal(DBusArray<uint8_t>(m_incomingMsg.size(),
                                                reinterpret_cast<uint8_t *>(m_incomingMsg.get())),
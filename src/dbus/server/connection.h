@@ -110,7 +110,7 @@ class Connection : public GDBusCXX::DBusObjectHelper, public Resource
 
     /** Connection.Process() */
     void process(const GDBusCXX::Caller_t &caller,
-                 const GDBusCXX::DBusArray<uint8_t> &message,
+                 const SharedBuffer &message,
                  const std::string &message_type);
     /** Connection.Close() */
     void close(const GDBusCXX::Caller_t &caller,
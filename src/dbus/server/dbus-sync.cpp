@@ -32,7 +32,8 @@ DBusSync::DBusSync(const SessionCommon::SyncParams &params,
     SyncContext(params.m_config, true),
     m_helper(helper),
     m_params(params),
-    m_waiting(false)
+    m_waiting(false),
+    m_passwordRequest(0)
 {
     setUserInterface(this);
 
@@ -104,6 +105,20 @@ DBusSync::DBusSync(const SessionCommon::SyncParams &params,
 
     // Forward the SourceSyncedSignal via D-Bus.
     m_sourceSyncedSignal.connect(boost::bind(m_helper.emitSourceSynced, _1, _2));
+
+    // Start looking up passwords for all active sources in parallel
+    // now, so that the sync doesn't have to wait for each of them
+    // when it needs them.
+    std::list<std::string> activeSources;
+    BOOST_FOREACH(const std::string &source,
+                  getSyncSources()) {
+        if (StringToSyncMode(getSyncSourceConfig(source)->getSync()) != SYNC_NONE) {
+            activeSources.push_back(source);
+        }
+    }
+    PasswordConfigProperty::prefetchPasswords(m_passwordCache, getKeyring(), *this,
+                                              PasswordConfigProperty::CHECK_PASSWORD_ALL,
+                                              activeSources);
 }
 
 DBusSync::~DBusSync()
@@ -133,8 +148,7 @@ boost::shared_ptr<TransportAgent> DBusSync::createTransportAgent()
             agent->serverAlerted();
         } else if (m_params.m_serverMode) {
             // Let transport return initial message to engine.
-            agent->storeMessage(GDBusCXX::DBusArray<uint8_t>(m_params.m_initialMessage.size(),
-                                                             reinterpret_cast<const uint8_t *>(m_params.m_initialMessage.get())),
+            agent->storeMessage(m_params.m_initialMessage,
                                 m_params.m_initialMessageType);
         }
 
@@ -234,44 +248,69 @@ void DBusSync::askPasswordAsync(const std::string &passwordName,
                                 const boost::function<void ()> &failureException)
 {
     // cannot handle more than one password request at a time
-    m_passwordSuccess.clear();
-    m_passwordFailure.clear();
+    m_passwordRequest++;
+    m_passwordSuccess = success;
+    m_passwordFailure = failureException;
     m_passwordDescr = descr;
+    m_passwordKey = key;
+
+    // Usually answered right away because of the prefetching in the
+    // constructor, otherwise the main loop delivers the result later.
+    m_passwordCache.load(getKeyring(), passwordName, descr, key,
+                         boost::bind(&DBusSync::keyringResponse, this, m_passwordRequest, _1),
+                         boost::bind(&DBusSync::keyringFailure, this, m_passwordRequest));
+}
+
+void DBusSync::keyringResponse(unsigned request, const InitStateString &password)
+{
+    if (request != m_passwordRequest || !m_passwordSuccess) {
+        return;
+    }
 
-    InitStateString password;
-    if (GetLoadPasswordSignal()(getKeyring(), passwordName, descr, key, password) &&
-        password.wasSet()) {
+    if (password.wasSet()) {
         // handled
+        boost::function<void (const std::string &)> success;
+        std::swap(success, m_passwordSuccess);
+        m_passwordFailure.clear();
         success(password);
         return;
     }
 
     try {
         SE_LOG_DEBUG(NULL, "asking parent for password");
-        m_passwordSuccess = success;
-        m_passwordFailure = failureException;
-        m_helper.emitPasswordRequest(descr, key);
+        m_helper.emitPasswordRequest(m_passwordDescr, m_passwordKey);
         if (!m_helper.connected()) {
             SE_LOG_DEBUG(NULL, "password request failed, lost connection");
             SE_THROW_EXCEPTION_STATUS(StatusException,
                                       StringPrintf("Could not get the '%s' password from user, no connection to UI.",
-                                                   descr.c_str()),
+                                                   m_passwordDescr.c_str()),
                                       STATUS_PASSWORD_TIMEOUT);
         }
         if (SuspendFlags::getSuspendFlags().getState() != SuspendFlags::NORMAL) {
             SE_LOG_DEBUG(NULL, "password request failed, was asked to terminate");
             SE_THROW_EXCEPTION_STATUS(StatusException,
                                       StringPrintf("Could not get the '%s' password from user, was asked to shut down.",
-                                                   descr.c_str()),
+                                                   m_passwordDescr.c_str()),
                                       STATUS_PASSWORD_TIMEOUT);
         }
     } catch (...) {
-        m_passwordSuccess.clear();
-        m_passwordFailure.clear();
-        failureException();
+        keyringFailure(request);
     }
 }
 
+void DBusSync::keyringFailure(unsigned request)
+{
+    if (request != m_passwordRequest || !m_passwordFailure) {
+        return;
+    }
+
+    // Called while handling the exception.
+    boost::function<void ()> failureException;
+    std::swap(failureException, m_passwordFailure);
+    m_passwordSuccess.clear();
+    failureException();
+}
+
 void DBusSync::passwordResponse(bool timedOut, bool aborted, const std::string &password)
 {
     boost::function<void (const std::string &)> success;
@@ -298,6 +337,8 @@ void DBusSync::passwordResponse(bool timedOut, bool aborted, const std::string &
                                                        m_passwordDescr.c_str()),
                                           SyncMLStatus(sysync::LOCERR_USERABORT));
             } else {
+                // Don't ask again for the same key.
+                m_passwordCache.store(m_passwordKey, password);
                 success(password);
             }
         } catch (...) {
@@ -51,11 +51,19 @@ class DBusSync : public SyncContext, private UserInterface
     boost::function<void (const std::string &)> m_passwordSuccess;
     boost::function<void ()> m_passwordFailure;
     std::string m_passwordDescr;
+    ConfigPasswordKey m_passwordKey;
+    /** identifies the current password request */
+    unsigned m_passwordRequest;
+    PasswordCache m_passwordCache;
     boost::signals2::connection m_parentWatch;
     boost::signals2::connection m_suspendFlagsWatch;
 
     void suspendFlagsChanged(SuspendFlags &flags);
 
+    /** result of the keyring lookup for the current password request */
+    void keyringResponse(unsigned request, const InitStateString &password);
+    void keyringFailure(unsigned request);
+
 public:
     DBusSync(const SessionCommon::SyncParams &params,
              SessionHelper &helper);
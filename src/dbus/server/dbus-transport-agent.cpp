@@ -41,23 +41,23 @@ void DBusTransportAgent::serverAlerted()
     }
 }
 
-void DBusTransportAgent::storeMessage(const GDBusCXX::DBusArray<uint8_t> &buffer,
+void DBusTransportAgent::storeMessage(const SharedBuffer &buffer,
                                       const std::string &type)
 {
     SE_LOG_DEBUG(NULL, "D-Bus transport: store incoming message, %ld bytes, %s (old state: %s, %s)",
-                 (long)buffer.first,
+                 (long)buffer.size(),
                  type.c_str(),
                  SessionCommon::ConnectionStateToString(m_state).c_str(),
                  m_error.c_str());
     if (m_state == SessionCommon::SETUP ||
         m_state == SessionCommon::WAITING) {
-        m_incomingMsg = SharedBuffer(reinterpret_cast<const char *>(buffer.second), buffer.first);
+        m_incomingMsg = buffer;
         m_incomingMsgType = type;
         m_state = SessionCommon::PROCESSING;
     } else if (m_state == SessionCommon::PROCESSING &&
                m_incomingMsgType == type &&
-               m_incomingMsg.size() == buffer.first &&
-               !memcmp(m_incomingMsg.get(), buffer.second, buffer.first)) {
+               m_incomingMsg.size() == buffer.size() &&
+               !memcmp(m_incomingMsg.get(), buffer.get(), buffer.size())) {
         // Exactly the same message, accept resend without error, and
         // without doing anything.
     } else {
@@ -73,7 +73,7 @@ class DBusTransportAgent : public TransportAgent
     DBusTransportAgent(SessionHelper &helper);
 
     void serverAlerted();
-    void storeMessage(const GDBusCXX::DBusArray<uint8_t> &buffer,
+    void storeMessage(const SharedBuffer &buffer,
                       const std::string &type);
     void storeState(const std::string &error);
 
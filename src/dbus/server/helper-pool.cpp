@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+#include "helper-pool.h"
+#include "server.h"
+
+#include <syncevo/ForkExec.h>
+#include <syncevo/util.h>
+
+#ifdef USE_DLT
+#include <syncevo/LogDLT.h>
+#endif
+
+#include <string.h>
+#include <signal.h>
+
+#include <boost/foreach.hpp>
+
+SE_BEGIN_CXX
+
+HelperPool::HelperPool(Server &server, size_t size) :
+    m_server(server),
+    m_size(size),
+    m_drained(false)
+{
+    SE_LOG_DEBUG(NULL, "keeping %ld idle helper(s) ready", (long)m_size);
+    scheduleRefill();
+}
+
+HelperPool::~HelperPool()
+{
+    drain();
+}
+
+boost::shared_ptr<HelperPool::Helper> HelperPool::claim(Logger::Level level)
+{
+    boost::shared_ptr<Helper> helper;
+    if (m_drained) {
+        return helper;
+    }
+
+    // Prefer helpers which have already connected.
+    std::list< boost::shared_ptr<Helper> >::iterator it, found = m_helpers.end();
+    for (it = m_helpers.begin(); it != m_helpers.end(); ++it) {
+        if ((*it)->m_level == level &&
+            (found == m_helpers.end() || (*it)->m_conn)) {
+            found = it;
+        }
+    }
+    if (found != m_helpers.end()) {
+        helper = *found;
+        m_helpers.erase(found);
+        helper->m_onConnect.disconnect();
+        helper->m_onQuit.disconnect();
+        helper->m_onFailure.disconnect();
+        helper->m_onOutput.disconnect();
+        SE_LOG_DEBUG(NULL, "handing out pooled helper %s (%s), %ld left",
+                     helper->m_forkExecParent->getInstance().c_str(),
+                     helper->m_conn ? "connected" : "starting",
+                     (long)m_helpers.size());
+    }
+
+    // Replace the claimed helper or the ones with the wrong log
+    // level once the caller is done with its own work.
+    scheduleRefill();
+    return helper;
+}
+
+void HelperPool::drain()
+{
+    if (!m_drained) {
+        SE_LOG_DEBUG(NULL, "stopping %ld idle helper(s)", (long)m_helpers.size());
+    }
+    m_drained = true;
+    m_refill.deactivate();
+    BOOST_FOREACH (const boost::shared_ptr<Helper> &helper, m_helpers) {
+        helper->m_onConnect.disconnect();
+        helper->m_onQuit.disconnect();
+        helper->m_onFailure.disconnect();
+        helper->m_onOutput.disconnect();
+        // SIGURG tells a helper which has not been used to quit
+        // normally, SIGTERM covers the case where it is still starting.
+        helper->m_forkExecParent->stop(SIGTERM);
+        helper->m_forkExecParent->stop(SIGURG);
+    }
+    m_helpers.clear();
+}
+
+void HelperPool::scheduleRefill()
+{
+    if (!m_drained && !m_refill) {
+        m_refill.runOnce(boost::bind(&HelperPool::refill, this));
+    }
+}
+
+void HelperPool::refill()
+{
+    if (m_drained) {
+        return;
+    }
+
+    // Helpers started with a different log level are useless, replace them.
+    Logger::Level level = m_server.getDBusLogLevel();
+    std::list< boost::shared_ptr<Helper> >::iterator it = m_helpers.begin();
+    while (it != m_helpers.end()) {
+        if ((*it)->m_level != level) {
+            (*it)->m_onQuit.disconnect();
+            (*it)->m_forkExecParent->stop(SIGTERM);
+            (*it)->m_forkExecParent->stop(SIGURG);
+            it = m_helpers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    try {
+        while (m_helpers.size() < m_size) {
+            startHelper(level);
+        }
+    } catch (...) {
+        Exception::handle();
+        drain();
+    }
+}
+
+void HelperPool::startHelper(Logger::Level level)
+{
+    boost::shared_ptr<Helper> helper(new Helper);
+    std::vector<std::string> args;
+    args.push_back("--dbus-verbosity");
+    args.push_back(StringPrintf("%d", level));
+    helper->m_forkExecParent = ForkExecParent::create("syncevo-dbus-helper", args);
+    helper->m_level = level;
+#ifdef USE_DLT
+    if (getenv("SYNCEVOLUTION_USE_DLT")) {
+        helper->m_forkExecParent->addEnvVar("SYNCEVOLUTION_USE_DLT", StringPrintf("%d", LoggerDLT::getCurrentDLTLogLevel()));
+    }
+#endif
+    // The Helper owns the connections, so "this" and the raw
+    // helper pointer are valid as long as the slots are connected.
+    helper->m_onConnect = helper->m_forkExecParent->m_onConnect.connect(boost::bind(&HelperPool::onConnect, this, helper.get(), _1));
+    helper->m_onQuit = helper->m_forkExecParent->m_onQuit.connect(boost::bind(&HelperPool::onQuit, this, helper.get(), _1));
+    helper->m_onFailure = helper->m_forkExecParent->m_onFailure.connect(boost::bind(&HelperPool::onFailure, this, helper.get(), _1, _2));
+    if (!getenv("SYNCEVOLUTION_DEBUG")) {
+        // Same as in Session::useHelperAsync(): must be connected
+        // before start() to get the output redirected.
+        helper->m_onOutput = helper->m_forkExecParent->m_onOutput.connect(&HelperPool::onOutput);
+    }
+    m_helpers.push_back(helper);
+    helper->m_forkExecParent->start();
+    SE_LOG_DEBUG(NULL, "started idle helper %s", helper->m_forkExecParent->getInstance().c_str());
+}
+
+void HelperPool::remove(Helper *helper)
+{
+    for (std::list< boost::shared_ptr<Helper> >::iterator it = m_helpers.begin();
+         it != m_helpers.end();
+         ++it) {
+        if (it->get() == helper) {
+            // We get called by a signal of the ForkExecParent, must
+            // not destroy it yet.
+            m_server.delayDeletion(helper->m_forkExecParent);
+            m_helpers.erase(it);
+            break;
+        }
+    }
+}
+
+void HelperPool::onConnect(Helper *helper, const GDBusCXX::DBusConnectionPtr &conn) throw ()
+{
+    try {
+        SE_LOG_DEBUG(NULL, "idle helper %s has connected",
+                     helper->m_forkExecParent->getInstance().c_str());
+        helper->m_conn = conn;
+    } catch (...) {
+        Exception::handle();
+    }
+}
+
+void HelperPool::onQuit(Helper *helper, int status) throw ()
+{
+    try {
+        bool connected = helper->m_conn.get() != NULL;
+        SE_LOG_DEBUG(NULL, "idle helper %s quit with return code %d",
+                     helper->m_forkExecParent->getInstance().c_str(),
+                     status);
+        remove(helper);
+        if (connected) {
+            scheduleRefill();
+        } else {
+            // Helper startup is broken. Don't keep forking new
+            // ones, sessions will report the problem when starting
+            // their own helper.
+            SE_LOG_DEBUG(NULL, "idle helper failed to start, disabling helper pool");
+            drain();
+        }
+    } catch (...) {
+        Exception::handle();
+    }
+}
+
+void HelperPool::onFailure(Helper *helper, SyncMLStatus status, const std::string &explanation) throw ()
+{
+    try {
+        SE_LOG_DEBUG(NULL, "idle helper %s failed, status code %d = %s, %s",
+                     helper->m_forkExecParent->getInstance().c_str(),
+                     status,
+                     Status2String(status).c_str(),
+                     explanation.c_str());
+    } catch (...) {
+        Exception::handle();
+    }
+}
+
+void HelperPool::onOutput(const char *buffer, size_t length)
+{
+    // treat null-bytes inside the buffer like line breaks
+    size_t off = 0;
+    do {
+        SE_LOG_ERROR("session-helper", "%s", buffer + off);
+        off += strlen(buffer + off) + 1;
+    } while (off < length);
+}
+
+SE_END_CXX
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+#ifndef HELPER_POOL_H
+#define HELPER_POOL_H
+
+#include <list>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/signals2.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <gdbus-cxx-bridge.h>
+#include <syncevo/Logging.h>
+#include <syncevo/SyncML.h>
+#include <syncevo/timeout.h>
+
+#include <syncevo/declarations.h>
+SE_BEGIN_CXX
+
+class Server;
+class ForkExecParent;
+
+/**
+ * Keeps a configurable number of syncevo-dbus-helper processes
+ * started and waiting for their first operation, so that a Session
+ * can skip the fork+exec and process startup when it needs a helper.
+ *
+ * A helper only ever runs one operation (see Session::doneCb()), so
+ * each pooled helper is handed out once and then replaced by a new
+ * one when the main loop is idle. The pool is disabled entirely
+ * when the size is zero (the default, see SYNCEVOLUTION_HELPER_POOL)
+ * and it stops refilling once the server noticed that files it
+ * depends on were modified, because new helpers would run with
+ * the new binaries and data files while the server is still the
+ * old one.
+ */
+class HelperPool : private boost::noncopyable
+{
+ public:
+    /**
+     * A pre-started helper. The slots connected by the pool are
+     * removed when the helper is claimed; the new owner then
+     * connects its own slots.
+     */
+    struct Helper
+    {
+        boost::shared_ptr<ForkExecParent> m_forkExecParent;
+
+        /** set once the helper has connected, empty while starting */
+        GDBusCXX::DBusConnectionPtr m_conn;
+
+        /** D-Bus log level passed to the helper via --dbus-verbosity */
+        Logger::Level m_level;
+
+        boost::signals2::scoped_connection m_onConnect, m_onQuit, m_onFailure, m_onOutput;
+    };
+
+    HelperPool(Server &server, size_t size);
+    ~HelperPool();
+
+    /**
+     * Hand out a pooled helper which was started with the given D-Bus
+     * log level. Returns an empty pointer if none is available, in
+     * which case the caller has to start its own helper.
+     */
+    boost::shared_ptr<Helper> claim(Logger::Level level);
+
+    /** stop all idle helpers and don't start new ones */
+    void drain();
+
+ private:
+    Server &m_server;
+    size_t m_size;
+    bool m_drained;
+    std::list< boost::shared_ptr<Helper> > m_helpers;
+    Timeout m_refill;
+
+    /** start helpers until the pool is full again */
+    void refill();
+    void scheduleRefill();
+    void startHelper(Logger::Level level);
+    void remove(Helper *helper);
+
+    void onConnect(Helper *helper, const GDBusCXX::DBusConnectionPtr &conn) throw ();
+    void onQuit(Helper *helper, int status) throw ();
+    void onFailure(Helper *helper, SyncMLStatus status, const std::string &explanation) throw ();
+    static void onOutput(const char *buffer, size_t length);
+};
+
+SE_END_CXX
+
+#endif // HELPER_POOL_H
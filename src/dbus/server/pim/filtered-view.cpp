@@ -68,8 +68,15 @@ void FilteredView::doStart()
     // Add initial content. Our processing of the new contact must not
     // cause changes to the parent view, otherwise the result will not
     // be inconsistent.
-    for (int index = 0; !isFull() && index < m_parent->size(); index++) {
-        addIndividual(index, *m_parent->getContact(index));
+    std::vector<int> candidates;
+    if (findCandidates(m_filter, candidates)) {
+        for (size_t i = 0; !isFull() && i < candidates.size(); i++) {
+            addIndividual(candidates[i], *m_parent->getContact(candidates[i]));
+        }
+    } else {
+        for (int index = 0; !isFull() && index < m_parent->size(); index++) {
+            addIndividual(index, *m_parent->getContact(index));
+        }
     }
 
     // Start listening to signals.
@@ -78,6 +85,16 @@ void FilteredView::doStart()
     m_parent->m_removedSignal.connect(ChangeSignal_t::slot_type(boost::bind(&FilteredView::removeIndividual, this, _1, _2)).track(m_self));
 }
 
+bool FilteredView::findCandidates(const boost::shared_ptr<IndividualFilter> &filter,
+                                  std::vector<int> &candidates)
+{
+    // Caller ID lookups ("phone" search) can use the phone number
+    // index of the full view instead of checking all contacts.
+    SimpleE164::NationalNumber_t number;
+    return filter->getNationalNumber(number) &&
+        m_parent->findNationalNumber(number, candidates);
+}
+
 bool FilteredView::isFull(const Entries_t &local2parent,
                           const boost::shared_ptr<IndividualFilter> &filter)
 {
@@ -173,14 +190,25 @@ void FilteredView::replaceFilter(const boost::shared_ptr<IndividualFilter> &indi
         //
         // 1. build new result list.
         Entries_t local2parent;
-        int candidate = 0;
-        while (!isFull(local2parent, individualFilter) &&
-               candidate < m_parent->size()) {
-            const IndividualData *data = m_parent->getContact(candidate);
-            if (individualFilter->matches(*data)) {
-                local2parent.push_back(candidate);
+        std::vector<int> candidates;
+        if (findCandidates(individualFilter, candidates)) {
+            for (size_t i = 0;
+                 !isFull(local2parent, individualFilter) && i < candidates.size();
+                 i++) {
+                if (individualFilter->matches(*m_parent->getContact(candidates[i]))) {
+                    local2parent.push_back(candidates[i]);
+                }
+            }
+        } else {
+            int candidate = 0;
+            while (!isFull(local2parent, individualFilter) &&
+                   candidate < m_parent->size()) {
+                const IndividualData *data = m_parent->getContact(candidate);
+                if (individualFilter->matches(*data)) {
+                    local2parent.push_back(candidate);
+                }
+                candidate++;
             }
-            candidate++;
         }
 
         // 2. morph existing one into new one.
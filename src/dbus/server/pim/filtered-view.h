@@ -48,6 +48,13 @@ class FilteredView : public IndividualView
                  const boost::shared_ptr<IndividualFilter> &filter);
     void init(const boost::shared_ptr<FilteredView> &self);
 
+    /**
+     * Indices of the parent entries which may match the filter.
+     * Returns false if all of them need to be checked.
+     */
+    bool findCandidates(const boost::shared_ptr<IndividualFilter> &filter,
+                        std::vector<int> &candidates);
+
     bool isFull() const { return isFull(m_local2parent, m_filter); }
     static bool isFull(const Entries_t &local2parent,
                        const boost::shared_ptr<IndividualFilter> &filter);
@@ -29,6 +29,7 @@
 #include <syncevo/LogRedirect.h>
 
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
@@ -431,6 +432,169 @@ void IndividualAggregator::removeContactDone(const GError *gerror,
 }
 
 
+/**
+ * Collects the per-contact results of addContacts(), modifyContacts()
+ * and removeContacts() and reports them once all operations are done.
+ */
+class IndividualAggregator::Batch : private boost::noncopyable
+{
+    Result<void (const BatchResult_t &)> m_result;
+    BatchResult_t m_results;
+    size_t m_pending;
+
+    void finished()
+    {
+        if (!--m_pending) {
+            m_result.done(m_results);
+        }
+    }
+
+ public:
+    Batch(const Result<void (const BatchResult_t &)> &result,
+          size_t size) :
+        m_result(result),
+        m_results(size),
+        m_pending(size)
+    {}
+
+    size_t size() const { return m_results.size(); }
+
+    /** to be called after starting all operations, handles empty batches */
+    void started() { if (m_results.empty()) { m_result.done(m_results); } }
+
+    void setID(size_t index, const std::string &localID) { m_results[index].first = localID; }
+
+    void done(size_t index) { finished(); }
+    void doneID(size_t index, const std::string &localID) { setID(index, localID); finished(); }
+
+    /** error callback, records the pending exception */
+    void failed(size_t index)
+    {
+        std::string explanation;
+        Exception::handle(explanation, HANDLE_EXCEPTION_NO_ERROR);
+        m_results[index].second = explanation;
+        finished();
+    }
+
+    /** the whole batch failed, for example because there is no address book */
+    void failedAll()
+    {
+        m_result.failed();
+    }
+};
+
+void IndividualAggregator::addContacts(const Result<void (const BatchResult_t &)> &result,
+                                       const std::vector<PersonaDetails> &details)
+{
+    boost::shared_ptr<Batch> batch(new Batch(result, details.size()));
+    runWithAddressBook(boost::bind(&IndividualAggregator::doAddContacts,
+                                   this,
+                                   batch,
+                                   details),
+                       boost::bind(&Batch::failedAll, batch));
+}
+
+void IndividualAggregator::doAddContacts(const boost::shared_ptr<Batch> &batch,
+                                         const std::vector<PersonaDetails> &details)
+{
+    // Submit all contacts at once. folks and EDS process them
+    // while we return to the main loop.
+    for (size_t index = 0; index < details.size(); index++) {
+        Result<void (const std::string &)> result(boost::bind(&Batch::doneID, batch, index, _1),
+                                                  boost::bind(&Batch::failed, batch, index));
+        try {
+            doAddContact(result, details[index]);
+        } catch (...) {
+            result.failed();
+        }
+    }
+    batch->started();
+}
+
+void IndividualAggregator::modifyContacts(const Result<void (const BatchResult_t &)> &result,
+                                          const std::vector< std::pair<std::string, PersonaDetails> > &contacts)
+{
+    boost::shared_ptr<Batch> batch(new Batch(result, contacts.size()));
+    runWithAddressBook(boost::bind(&IndividualAggregator::doModifyContacts,
+                                   this,
+                                   batch,
+                                   contacts),
+                       boost::bind(&Batch::failedAll, batch));
+}
+
+void IndividualAggregator::doModifyContacts(const boost::shared_ptr<Batch> &batch,
+                                            const std::vector< std::pair<std::string, PersonaDetails> > &contacts)
+{
+    Personas_t personas;
+    getPersonas(personas);
+    for (size_t index = 0; index < contacts.size(); index++) {
+        const std::string &localID = contacts[index].first;
+        Result<void ()> result(boost::bind(&Batch::done, batch, index),
+                               boost::bind(&Batch::failed, batch, index));
+        batch->setID(index, localID);
+        try {
+            Personas_t::const_iterator it = personas.find(localID);
+            if (it == personas.end()) {
+                SE_THROW(StringPrintf("contact with local ID '%s' not found in system address book", localID.c_str()));
+            }
+            doModifyContact(result, it->second, contacts[index].second);
+        } catch (...) {
+            result.failed();
+        }
+    }
+    batch->started();
+}
+
+void IndividualAggregator::removeContacts(const Result<void (const BatchResult_t &)> &result,
+                                          const std::vector<std::string> &localIDs)
+{
+    boost::shared_ptr<Batch> batch(new Batch(result, localIDs.size()));
+    runWithAddressBook(boost::bind(&IndividualAggregator::doRemoveContacts,
+                                   this,
+                                   batch,
+                                   localIDs),
+                       boost::bind(&Batch::failedAll, batch));
+}
+
+void IndividualAggregator::doRemoveContacts(const boost::shared_ptr<Batch> &batch,
+                                            const std::vector<std::string> &localIDs)
+{
+    Personas_t personas;
+    getPersonas(personas);
+    for (size_t index = 0; index < localIDs.size(); index++) {
+        const std::string &localID = localIDs[index];
+        Result<void ()> result(boost::bind(&Batch::done, batch, index),
+                               boost::bind(&Batch::failed, batch, index));
+        batch->setID(index, localID);
+        try {
+            Personas_t::const_iterator it = personas.find(localID);
+            if (it == personas.end()) {
+                SE_THROW(StringPrintf("contact with local ID '%s' not found in system address book", localID.c_str()));
+            }
+            doRemoveContact(result, it->second);
+        } catch (...) {
+            result.failed();
+        }
+    }
+    batch->started();
+}
+
+void IndividualAggregator::getPersonas(Personas_t &personas)
+{
+    // One pass over the address book instead of one per contact,
+    // as in doRunWithPersona().
+    typedef GeeCollCXX< GeeMapEntryWrapper<const gchar *, FolksPersona *> > Coll;
+    Coll coll(folks_persona_store_get_personas(m_systemStore), ADD_REF);
+    BOOST_FOREACH (const Coll::value_type &entry, coll) {
+        // key seems to be <store id>:<persona ID>
+        const gchar *key = entry.key();
+        const gchar *colon = strchr(key, ':');
+        if (colon) {
+            personas[colon + 1] = entry.value();
+        }
+    }
+}
+
 void IndividualAggregator::runWithAddressBook(const boost::function<void ()> &operation,
                                               const ErrorCb_t &onError) throw()
 {
@@ -184,6 +184,14 @@ class IndividualFilter
 
     /** true if the contact matches the filter */
     virtual bool matches(const IndividualData &data) const = 0;
+
+    /**
+     * True if the filter only matches contacts which have a phone
+     * number with the given national number in
+     * LocaleFactory::Precomputed. Allows views to check only the
+     * contacts found via IndividualView::findNationalNumber().
+     */
+    virtual bool getNationalNumber(SimpleE164::NationalNumber_t &number) const { return false; }
 };
 
 /**
@@ -303,6 +311,18 @@ class IndividualAggregator
    void removeContactDone(const GError *gerror,
                           const Result<void ()> &result) throw();
 
+   class Batch;
+   void doAddContacts(const boost::shared_ptr<Batch> &batch,
+                      const std::vector<PersonaDetails> &details);
+   void doModifyContacts(const boost::shared_ptr<Batch> &batch,
+                         const std::vector< std::pair<std::string, PersonaDetails> > &contacts);
+   void doRemoveContacts(const boost::shared_ptr<Batch> &batch,
+                         const std::vector<std::string> &localIDs);
+
+   /** local ID -> persona in the prepared system address book */
+   typedef std::map<std::string, FolksPersona *> Personas_t;
+   void getPersonas(Personas_t &personas);
+
  public:
     /**
      * Creates an idle IndividualAggregator. Configure it and
@@ -376,6 +396,35 @@ class IndividualAggregator
     */
    void removeContact(const Result<void ()> &result,
                       const std::string &localID);
+
+   /**
+    * Local ID plus error message for each contact of a batch
+    * operation, in the order of the request. The error message is
+    * empty if the operation succeeded for the contact.
+    */
+   typedef std::vector< std::pair<std::string, std::string> > BatchResult_t;
+
+   /**
+    * Add several contacts to the system address book. All of them
+    * are submitted at once, the result is returned once all of them
+    * are done. A failure for one contact does not affect the others.
+    */
+   void addContacts(const Result<void (const BatchResult_t &)> &result,
+                    const std::vector<PersonaDetails> &details);
+
+   /**
+    * Modify several contacts (local ID + details) in the system
+    * address book, like addContacts().
+    */
+   void modifyContacts(const Result<void (const BatchResult_t &)> &result,
+                       const std::vector< std::pair<std::string, PersonaDetails> > &contacts);
+
+   /**
+    * Remove several contacts from the system address book, like
+    * addContacts().
+    */
+   void removeContacts(const Result<void (const BatchResult_t &)> &result,
+                       const std::vector<std::string> &localIDs);
 };
 
 
@@ -18,14 +18,52 @@
  */
 
 #include "full-view.h"
+#include "individual-traits.h"
 
 #include <syncevo/BoostHelper.h>
+#include <syncevo/ThreadSupport.h>
 
-#include <boost/dynamic_bitset.hpp>
+#include <boost/scoped_array.hpp>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
+/**
+ * Recomputes sort criteria and (optionally) locale-dependent
+ * values for a range of entries. Each job only writes into its own
+ * entries and flags, so several jobs can run in parallel.
+ */
+struct InitJob
+{
+    const IndividualCompare *m_compare;
+    const LocaleFactory *m_locale;
+    IndividualData **m_entries;
+    char *m_modified;
+    size_t m_start, m_end;
+    /** exception thrown by the job, rethrown by the main thread */
+    std::string m_failure;
+};
+
+static void InitEntries(InitJob &job) throw ()
+{
+    try {
+        for (size_t i = job.m_start; i < job.m_end; i++) {
+            IndividualData &data = *job.m_entries[i];
+            job.m_modified[i] = data.init(job.m_compare, job.m_locale, data.m_individual);
+        }
+    } catch (...) {
+        Exception::handle(job.m_failure, HANDLE_EXCEPTION_NO_ERROR);
+    }
+}
+
+#ifdef HAVE_THREAD_SUPPORT
+static gpointer InitThread(gpointer data)
+{
+    InitEntries(*static_cast<InitJob *>(data));
+    return NULL;
+}
+#endif
+
 FullView::FullView(const FolksIndividualAggregatorCXX &folks,
                    const boost::shared_ptr<LocaleFactory> &locale) :
     m_folks(folks),
@@ -70,6 +108,7 @@ void FullView::doStart()
 
     // Copy the sorted data into the view in one go.
     m_entries.insert(m_entries.begin(), individuals.begin(), individuals.end());
+    rebuildPhoneIndex();
     // Avoid loop if no-one is listening.
     if (!m_addedSignal.empty()) {
         for (size_t index = 0; index < m_entries.size(); index++) {
@@ -151,6 +190,10 @@ void FullView::individualModified(gpointer gobject,
     SE_LOG_DEBUG(NULL, "individual %p modified",
                  gobject);
     FolksIndividual *individual = FOLKS_INDIVIDUAL(gobject);
+    // The serialized data must be recreated on demand, otherwise
+    // clients reading the individual before the idle processing
+    // below would get outdated content.
+    FolksIndividualInvalidateDBus(individual);
     // Delay the expensive modification check until the process is
     // idle, because in practice we get several change signals for
     // each contact change in EDS.
@@ -195,6 +238,7 @@ void FullView::doAddIndividual(Entries_t::auto_type &data)
                          IndividualDataCompare(m_compare));
     size_t index = it - m_entries.begin();
     it = m_entries.insert(it, data.release());
+    indexPhoneNumbers(*it);
     SE_LOG_DEBUG(NULL, "full view: added at #%ld/%ld", (long)index, (long)m_entries.size());
     m_addedSignal(index, *it);
     waitForIdle();
@@ -235,13 +279,16 @@ void FullView::modifyIndividual(FolksIndividual *individual)
                 // as simple as possible, because this is not expected
                 // to happen often.
                 SE_LOG_DEBUG(NULL, "full view: temporarily removed at #%ld/%ld", (long)index, (long)m_entries.size());
+                unindexPhoneNumbers(*it);
                 Entries_t::auto_type old = m_entries.release(it);
                 m_removedSignal(index, *old);
                 doAddIndividual(data);
             } else {
                 SE_LOG_DEBUG(NULL, "full view: modified at #%ld/%ld", (long)index, (long)m_entries.size());
                 // Use potentially modified pre-computed data.
+                unindexPhoneNumbers(*it);
                 m_entries.replace(it, data.release());
+                indexPhoneNumbers(*it);
                 m_modifiedSignal(index, *it);
                 waitForIdle();
             }
@@ -261,6 +308,7 @@ void FullView::removeIndividual(FolksIndividual *individual)
         if (it->m_individual.get() == individual) {
             size_t index = it - m_entries.begin();
             SE_LOG_DEBUG(NULL, "full view: removed at #%ld/%ld", (long)index, (long)m_entries.size());
+            unindexPhoneNumbers(*it);
             Entries_t::auto_type data = m_entries.release(it);
             m_removedSignal(index, *data);
             waitForIdle();
@@ -271,6 +319,67 @@ void FullView::removeIndividual(FolksIndividual *individual)
     SE_LOG_DEBUG(NULL, "full view: individual to be removed not found");
 }
 
+void FullView::indexPhoneNumbers(const IndividualData &data)
+{
+    BOOST_FOREACH (const SimpleE164 &number, data.m_precomputed.m_phoneNumbers) {
+        m_phoneIndex.insert(std::make_pair(number.m_nationalNumber, &data));
+    }
+}
+
+void FullView::unindexPhoneNumbers(const IndividualData &data)
+{
+    BOOST_FOREACH (const SimpleE164 &number, data.m_precomputed.m_phoneNumbers) {
+        std::pair<PhoneIndex_t::iterator, PhoneIndex_t::iterator> range =
+            m_phoneIndex.equal_range(number.m_nationalNumber);
+        for (PhoneIndex_t::iterator it = range.first; it != range.second; ++it) {
+            if (it->second == &data) {
+                // Only one entry per number, duplicate numbers
+                // are handled by the next iteration.
+                m_phoneIndex.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+void FullView::rebuildPhoneIndex()
+{
+    m_phoneIndex.clear();
+    BOOST_FOREACH (const IndividualData &data, m_entries) {
+        indexPhoneNumbers(data);
+    }
+}
+
+bool FullView::findNationalNumber(SimpleE164::NationalNumber_t number, std::vector<int> &indices)
+{
+    IndividualDataCompare compare(m_compare);
+    std::pair<PhoneIndex_t::const_iterator, PhoneIndex_t::const_iterator> range =
+        m_phoneIndex.equal_range(number);
+    for (PhoneIndex_t::const_iterator it = range.first; it != range.second; ++it) {
+        const IndividualData &data = *it->second;
+        // Binary search finds the first entry with the same sort
+        // criteria, the individual itself must be among those.
+        Entries_t::const_iterator entry =
+            std::lower_bound(m_entries.begin(),
+                             m_entries.end(),
+                             data,
+                             compare);
+        while (entry != m_entries.end() &&
+               &*entry != &data &&
+               !compare(data, *entry)) {
+            ++entry;
+        }
+        if (entry != m_entries.end() &&
+            &*entry == &data) {
+            indices.push_back(entry - m_entries.begin());
+        }
+    }
+    // An individual may have the same number more than once.
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return true;
+}
+
 void FullView::onIdle()
 {
     SE_LOG_DEBUG(NULL, "full view: process is idle");
@@ -312,16 +421,61 @@ void FullView::setCompare(const boost::shared_ptr<IndividualCompare> &compare)
     // Change sort criteria and sort.
     // Optionally also re-compute locale-dependent values, if
     // the locale changed (see setLocale()).
+    //
+    // This is the expensive part (collation keys, transliteration,
+    // phone number parsing), so it gets split up between several
+    // threads for large views. Folks objects are only read while
+    // the main thread waits here, and the IndividualCompare and
+    // LocaleFactory implementations are thread-safe.
     LocaleFactory *locale = m_localeChanged ? m_locale.get() : NULL;
     m_localeChanged = false;
-    boost::dynamic_bitset<size_t> modified(locale ? m_entries.size() : 0);
-    for (size_t i = 0; i < m_entries.size(); i++ ) {
-        IndividualData &data = m_entries[i];
-        bool preComputedModified = data.init(m_compare.get(), locale, data.m_individual);
-        if (locale && preComputedModified) {
-            modified.set(i);
+    std::vector<char> modified(m_entries.size());
+    size_t threads = 0;
+#ifdef HAVE_THREAD_SUPPORT
+# if GLIB_CHECK_VERSION(2, 36, 0)
+    threads = g_get_num_processors();
+# else
+    threads = 2;
+# endif
+    // Not worth starting threads for a handful of contacts.
+    threads = std::min(threads, m_entries.size() / 500);
+#endif
+    std::vector<InitJob> jobs(std::max(threads, (size_t)1));
+    size_t chunk = (m_entries.size() + jobs.size() - 1) / jobs.size();
+    for (size_t i = 0; i < jobs.size(); i++) {
+        InitJob &job = jobs[i];
+        job.m_compare = m_compare.get();
+        job.m_locale = locale;
+        job.m_entries = old.get();
+        job.m_modified = modified.empty() ? NULL : &modified[0];
+        job.m_start = std::min(m_entries.size(), i * chunk);
+        job.m_end = std::min(m_entries.size(), (i + 1) * chunk);
+    }
+#ifdef HAVE_THREAD_SUPPORT
+    std::vector<GThread *> running;
+    for (size_t i = 0; i + 1 < jobs.size(); i++) {
+        running.push_back(g_thread_new("sort keys", InitThread, &jobs[i]));
+    }
+#endif
+    // last chunk in the current thread
+    InitEntries(jobs.back());
+#ifdef HAVE_THREAD_SUPPORT
+    BOOST_FOREACH (GThread *thread, running) {
+        g_thread_join(thread);
+    }
+#endif
+    BOOST_FOREACH (const InitJob &job, jobs) {
+        if (!job.m_failure.empty()) {
+            Exception::tryRethrow(job.m_failure, true);
         }
     }
+    if (threads > 1) {
+        SE_LOG_DEBUG(NULL, "recomputed sort keys of %ld contacts in %ld threads",
+                     (long)m_entries.size(), (long)threads);
+    }
+    if (locale) {
+        rebuildPhoneIndex();
+    }
     m_entries.sort(IndividualDataCompare(m_compare));
 
     // Now check for changes.
@@ -22,6 +22,8 @@
 
 #include "view.h"
 
+#include <map>
+
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
@@ -46,6 +48,18 @@ class FullView : public IndividualView
     typedef boost::ptr_vector<IndividualData> Entries_t;
     Entries_t m_entries;
 
+    /**
+     * National numbers of the precomputed phone numbers of all
+     * entries, for findNationalNumber(). Points into m_entries and
+     * must be updated whenever entries get added, replaced or
+     * removed.
+     */
+    typedef std::multimap<SimpleE164::NationalNumber_t, const IndividualData *> PhoneIndex_t;
+    PhoneIndex_t m_phoneIndex;
+    void indexPhoneNumbers(const IndividualData &data);
+    void unindexPhoneNumbers(const IndividualData &data);
+    void rebuildPhoneIndex();
+
     /**
      * The sort object to be used.
      */
@@ -144,6 +158,7 @@ class FullView : public IndividualView
     virtual void doStart();
     virtual int size() const { return (int)m_entries.size(); }
     virtual const IndividualData *getContact(int index) { return (index >= 0 && (unsigned)index < m_entries.size()) ? &m_entries[index] : NULL; }
+    virtual bool findNationalNumber(SimpleE164::NationalNumber_t number, std::vector<int> &indices);
 };
 
 SE_END_CXX
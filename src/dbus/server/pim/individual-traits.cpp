@@ -986,10 +986,12 @@ void Details2Persona(const Result<void ()> &result, const PersonaDetails &detail
     Details2PersonaStep(NULL, pending);
 }
 
-void FolksIndividual2DBus(const FolksIndividualCXX &individual, GDBusCXX::builder_type &builder)
+/**
+ * Adds the entries of the D-Bus dict for the individual to a builder
+ * which already has the dict open.
+ */
+static void SerializeIndividual(const FolksIndividualCXX &individual, GDBusCXX::builder_type &builder)
 {
-    g_variant_builder_open(&builder, G_VARIANT_TYPE(INDIVIDUAL_DICT)); // dict
-
     FolksNameDetails *name = FOLKS_NAME_DETAILS(individual.get());
     SerializeFolks(builder, name, folks_name_details_get_full_name,
                    CONTACT_HASH_FULL_NAME);
@@ -1079,8 +1081,59 @@ FolksPresenceType folks_presence_details_get_presence_type (FolksPresenceDetails
 const gchar* folks_presence_details_get_presence_message (FolksPresenceDetails* self);
 const gchar* folks_presence_details_get_presence_status (FolksPresenceDetails* self);
 #endif
+}
+
+static FolksIndividualDBusCacheStats DBusCacheStats;
 
-    g_variant_builder_close(&builder); // dict
+/** key for the serialized individual, attached to the FolksIndividual */
+static GQuark DBusCacheQuark()
+{
+    static GQuark quark = g_quark_from_static_string("syncevolution-pim-dbus-individual");
+    return quark;
+}
+
+void FolksIndividual2DBus(const FolksIndividualCXX &individual, GDBusCXX::builder_type &builder)
+{
+    static const bool enabled = !getenv("SYNCEVOLUTION_PIM_NO_DBUS_CACHE");
+    GObject *object = G_OBJECT(const_cast<FolksIndividual *>(individual.get()));
+
+    GVariant *dict = enabled ?
+        static_cast<GVariant *>(g_object_get_qdata(object, DBusCacheQuark())) :
+        NULL;
+    if (dict) {
+        DBusCacheStats.m_hits++;
+        g_variant_builder_add_value(&builder, dict);
+        return;
+    }
+
+    GVariantBuilder content;
+    g_variant_builder_init(&content, G_VARIANT_TYPE(INDIVIDUAL_DICT)); // dict
+    SerializeIndividual(individual, content);
+    dict = g_variant_ref_sink(g_variant_builder_end(&content));
+    DBusCacheStats.m_misses++;
+    g_variant_builder_add_value(&builder, dict);
+    if (enabled) {
+        // Ownership passes to the individual. The reference is
+        // dropped when the individual gets destroyed or invalidated.
+        g_object_set_qdata_full(object, DBusCacheQuark(), dict,
+                                (GDestroyNotify)g_variant_unref);
+    } else {
+        g_variant_unref(dict);
+    }
+}
+
+void FolksIndividualInvalidateDBus(FolksIndividual *individual)
+{
+    GVariant *dict = static_cast<GVariant *>(g_object_steal_qdata(G_OBJECT(individual), DBusCacheQuark()));
+    if (dict) {
+        DBusCacheStats.m_invalidations++;
+        g_variant_unref(dict);
+    }
+}
+
+const FolksIndividualDBusCacheStats &FolksIndividualDBusCacheStatistics()
+{
+    return DBusCacheStats;
 }
 
 SE_END_CXX
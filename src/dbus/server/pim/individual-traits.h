@@ -35,7 +35,31 @@
 SE_BEGIN_CXX
 
 void DBus2PersonaDetails(GDBusCXX::ExtractArgs &context, GDBusCXX::reader_type &iter, PersonaDetails &details);
+/**
+ * Serializes the individual. The result is cached in the individual,
+ * so repeatedly sending the same individual only needs to add a
+ * reference to the existing GVariant. FolksIndividualInvalidateDBus()
+ * must be called when the individual changes. Setting
+ * SYNCEVOLUTION_PIM_NO_DBUS_CACHE disables the caching.
+ */
 void FolksIndividual2DBus(const FolksIndividualCXX &individual, GDBusCXX::builder_type &builder);
+
+/** discards the cached result of FolksIndividual2DBus(), if any */
+void FolksIndividualInvalidateDBus(FolksIndividual *individual);
+
+/** usage statistics of the FolksIndividual2DBus() cache */
+struct FolksIndividualDBusCacheStats
+{
+    FolksIndividualDBusCacheStats() : m_hits(0), m_misses(0), m_invalidations(0) {}
+
+    /** individual was sent using the cached GVariant */
+    size_t m_hits;
+    /** individual had to be serialized */
+    size_t m_misses;
+    /** cached GVariant was discarded because of a change */
+    size_t m_invalidations;
+};
+const FolksIndividualDBusCacheStats &FolksIndividualDBusCacheStatistics();
 void Details2Persona(const Result<void ()> &result, const PersonaDetails &details, FolksPersona *persona);
 
 SE_END_CXX
@@ -24,6 +24,8 @@
 #include "locale-factory.h"
 #include "folks.h"
 
+#include <syncevo/ThreadSupport.h>
+
 #include <libebook/libebook.h>
 
 #include <phonenumbers/phonenumberutil.h>
@@ -67,8 +69,19 @@ class CompareBoost : public IndividualCompare, private boost::noncopyable {
     const boost::locale::collator<char> &m_collator;
     std::unique_ptr<icu::Transliterator> m_trans;
 
+    /**
+     * A Transliterator must not be used by more than one thread at
+     * a time, but transform() gets called in parallel by
+     * FullView::setCompare(). Each call therefore borrows one of
+     * these clones of m_trans and creates a new one when none is
+     * idle.
+     */
+    mutable DynMutex m_idleMutex;
+    mutable std::vector<icu::Transliterator *> m_idleTrans;
+
 public:
     CompareBoost(const std::locale &locale);
+    ~CompareBoost();
 
     std::string transform(const char *string) const;
     std::string transform(const std::string &string) const;
@@ -105,6 +118,13 @@ CompareBoost::CompareBoost(const std::locale &locale) :
     }
 }
 
+CompareBoost::~CompareBoost()
+{
+    BOOST_FOREACH (icu::Transliterator *trans, m_idleTrans) {
+        delete trans;
+    }
+}
+
 std::string CompareBoost::transform(const char *string) const
 {
     if (!string) {
@@ -118,10 +138,26 @@ std::string CompareBoost::transform(const std::string &string) const
     // TODO: use e_collator_generate_key
 
     if (m_trans.get()) {
+        std::unique_ptr<icu::Transliterator> trans;
+        DynMutex::Guard guard = m_idleMutex.lock();
+        if (m_idleTrans.empty()) {
+            guard.unlock();
+            trans.reset(m_trans->clone());
+        } else {
+            trans.reset(m_idleTrans.back());
+            m_idleTrans.pop_back();
+            guard.unlock();
+        }
+
         // std::string result;
         // m_trans->transliterate(icu::StringPiece(string), icu::StringByteSink<std::string>(&result));
         icu::UnicodeString buffer(string.c_str());
-        m_trans->transliterate(buffer);
+        trans->transliterate(buffer);
+
+        guard = m_idleMutex.lock();
+        m_idleTrans.push_back(trans.release());
+        guard.unlock();
+
         std::string result;
         buffer.toUTF8String(result);
         result = m_collator.transform(DEFAULT_COLLATION_LEVEL, result);
@@ -918,6 +954,12 @@ public:
         return false;
     }
 
+    virtual bool getNationalNumber(SimpleE164::NationalNumber_t &number) const
+    {
+        number = m_number.m_nationalNumber;
+        return true;
+    }
+
     virtual std::string getEBookFilter() const
     {
         std::string tel = m_number.toString();
@@ -24,6 +24,8 @@
 #include "full-view.h"
 #include "merge-view.h"
 #include "edsf-view.h"
+#include "window-view.h"
+#include "snapshot.h"
 #include "../resource.h"
 #include "../client.h"
 #include "../session.h"
@@ -98,6 +100,7 @@ Manager::~Manager()
     // Clear the pending queue before self-desctructing, because the
     // entries hold pointers to this instance.
     m_pending.clear();
+    flushSnapshot();
     if (m_preventingAutoTerm) {
         m_server->autoTermUnref();
     }
@@ -164,6 +167,9 @@ void Manager::init()
     add(this, &Manager::addContact, "AddContact");
     add(this, &Manager::modifyContact, "ModifyContact");
     add(this, &Manager::removeContact, "RemoveContact");
+    add(this, &Manager::addContacts, "AddContacts");
+    add(this, &Manager::modifyContacts, "ModifyContacts");
+    add(this, &Manager::removeContacts, "RemoveContacts");
     add(emitSyncProgress);
 
     // Ready, make it visible via D-Bus.
@@ -325,6 +331,47 @@ void Manager::start()
         m_preventingAutoTerm = true;
     }
     m_folks->start();
+
+    if (!getenv("SYNCEVOLUTION_NO_PIM_SNAPSHOT")) {
+        // Until folks is done loading, searches are answered with
+        // the contacts from a previous run.
+        boost::shared_ptr<IndividualView> mainView = m_folks->getMainView();
+        m_mainViewQuiescence = mainView->m_quiescenceSignal.connect(boost::bind(&Manager::mainViewQuiescent, this));
+        if (!mainView->isQuiescent() && !m_snapshot) {
+            m_snapshot = ContactSnapshot::load(ContactSnapshot::getFilename());
+        }
+    }
+}
+
+/** seconds between the last change in the main view and writing the snapshot */
+static const int SNAPSHOT_SAVE_DELAY = 60;
+
+void Manager::mainViewQuiescent()
+{
+    if (m_snapshot) {
+        SE_LOG_DEBUG(NULL, "unified address book is ready, no longer using the snapshot");
+        m_snapshot.reset();
+    }
+    // The main view becomes quiescent again after each change. Write
+    // the snapshot only once things have settled down.
+    m_snapshotSave.runOnce(SNAPSHOT_SAVE_DELAY,
+                           boost::bind(&Manager::saveSnapshot, this));
+}
+
+void Manager::saveSnapshot()
+{
+    boost::shared_ptr<IndividualView> mainView = m_folks->getMainView();
+    if (mainView->isQuiescent()) {
+        ContactSnapshot::save(*mainView, ContactSnapshot::getFilename());
+    }
+}
+
+void Manager::flushSnapshot()
+{
+    if (m_snapshotSave) {
+        m_snapshotSave.deactivate();
+        saveSnapshot();
+    }
 }
 
 void Manager::stop()
@@ -340,6 +387,8 @@ void Manager::stop()
     // one inside m_folks, one given back to us here.
     if (m_folks->getMainView().use_count() <= 2) {
         SE_LOG_DEBUG(NULL, "restarting due to Manager.Stop()");
+        flushSnapshot();
+        m_mainViewQuiescence.disconnect();
         initFolks();
         initDatabases();
         initSorting(m_sortOrder);
@@ -400,6 +449,8 @@ class ViewResource : public Resource, public GDBusCXX::DBusObjectHelper
 
     boost::weak_ptr<ViewResource> m_self;
     GDBusCXX::DBusRemoteObject m_viewAgent;
+    /** the part of the search result that the agent is told about, see SetWindow() */
+    boost::shared_ptr<WindowView> m_window;
     boost::shared_ptr<IndividualView> m_view;
     boost::shared_ptr<LocaleFactory> m_locale;
     boost::weak_ptr<Client> m_owner;
@@ -430,7 +481,8 @@ class ViewResource : public Resource, public GDBusCXX::DBusObjectHelper
                     agentPath,
                     AGENT_IFACE,
                     ID),
-        m_view(view),
+        m_window(WindowView::create(view)),
+        m_view(m_window),
         m_locale(locale),
         m_owner(owner),
         m_filter(filter),
@@ -697,6 +749,7 @@ class ViewResource : public Resource, public GDBusCXX::DBusObjectHelper
         add(this, &ViewResource::close, "Close");
         add(this, &ViewResource::refineSearch, "RefineSearch");
         add(this, &ViewResource::replaceSearch, "ReplaceSearch");
+        add(this, &ViewResource::setWindow, "SetWindow");
         activate();
 
         // The view might have been started already, for example when
@@ -786,6 +839,14 @@ public:
                     }
                 }
             }
+            // The contacts get serialized after returning, so these
+            // numbers cover all earlier reads.
+            const FolksIndividualDBusCacheStats &stats = FolksIndividualDBusCacheStatistics();
+            SE_LOG_DEBUG(NULL, "reading %ld contacts, serialized contacts so far: %ld cached, %ld new, %ld invalidated",
+                         (long)ids.size(),
+                         (long)stats.m_hits,
+                         (long)stats.m_misses,
+                         (long)stats.m_invalidations);
         }
     }
 
@@ -816,6 +877,12 @@ public:
         redoSearch(refine);
     }
 
+    /** ViewControl.SetWindow() */
+    void setWindow(int start, int count)
+    {
+        m_window->setWindow(start, count);
+    }
+
     /**
      * Start filtering again, using the current environment. To be
      * called after a locale change or when m_filter changed.
@@ -916,6 +983,7 @@ void Manager::doSearch(const ESourceRegistryCXX &registry,
     view = m_folks->getMainView();
     bool quiescent = view->isQuiescent();
     std::string ebookFilter;
+    boost::shared_ptr<ContactSnapshot> snapshot;
     // Always use a filtered view. That way we can implement ReplaceView or RefineView
     // without having to switch from a FullView to a FilteredView.
     boost::shared_ptr<IndividualFilter> individualFilter = m_locale->createFilter(filter, 0);
@@ -924,16 +992,22 @@ void Manager::doSearch(const ESourceRegistryCXX &registry,
         // Don't search via EDS directly because the unified
         // address book is ready.
         ebookFilter.clear();
+    } else {
+        snapshot = m_snapshot;
     }
     view = FilteredView::create(view, individualFilter);
     view->setName(StringPrintf("filtered view%u", ViewResource::getNextViewNumber()));
 
-    SE_LOG_DEBUG(NULL, "preparing %s: EDS search term is '%s', active address books %s",
+    SE_LOG_DEBUG(NULL, "preparing %s: EDS search term is '%s', %s snapshot, active address books %s",
                  view->getName(),
                  ebookFilter.c_str(),
+                 snapshot ? "with" : "no",
                  boost::join(m_enabledEBooks, " ").c_str());
-    if (!ebookFilter.empty() && !m_enabledEBooks.empty()) {
-        // Set up direct searching in all active address books.
+    if ((!ebookFilter.empty() || snapshot) && !m_enabledEBooks.empty()) {
+        // Set up direct searching in all active address books,
+        // using the snapshot where possible because that is faster
+        // than asking EDS and also works for filters which cannot
+        // be expressed as EBook query.
         // These searches are done once, so don't bother to deal
         // with future changes to the active address books or
         // the sort order.
@@ -945,17 +1019,28 @@ void Manager::doSearch(const ESourceRegistryCXX &registry,
             m_locale->createCompare(m_sortOrder);
 
         BOOST_FOREACH (const std::string &uuid, m_enabledEBooks) {
-            searches.push_back(EDSFView::create(registry,
-                                                uuid,
-                                                ebookFilter));
-            searches.back()->setName(StringPrintf("eds view %s %s", uuid.c_str(), ebookFilter.c_str()));
+            if (snapshot && snapshot->hasAddressBook(uuid)) {
+                searches.push_back(SnapshotView::create(registry,
+                                                        uuid,
+                                                        snapshot,
+                                                        individualFilter,
+                                                        m_locale));
+                searches.back()->setName(StringPrintf("snapshot view %s", uuid.c_str()));
+            } else if (!ebookFilter.empty()) {
+                searches.push_back(EDSFView::create(registry,
+                                                    uuid,
+                                                    ebookFilter));
+                searches.back()->setName(StringPrintf("eds view %s %s", uuid.c_str(), ebookFilter.c_str()));
+            }
+        }
+        if (!searches.empty()) {
+            boost::shared_ptr<MergeView> merge(MergeView::create(view,
+                                                                 searches,
+                                                                 m_locale,
+                                                                 compare));
+            merge->setName(StringPrintf("merge view%u", ViewResource::getNextViewNumber()));
+            view = merge;
         }
-        boost::shared_ptr<MergeView> merge(MergeView::create(view,
-                                                             searches,
-                                                             m_locale,
-                                                             compare));
-        merge->setName(StringPrintf("merge view%u", ViewResource::getNextViewNumber()));
-        view = merge;
     }
 
     boost::shared_ptr<ViewResource> viewResource(ViewResource::create(view,
@@ -1844,4 +1929,46 @@ void Manager::removeContact(const boost::shared_ptr<GDBusCXX::Result0> &result,
     }
 }
 
+void Manager::addContacts(const boost::shared_ptr< GDBusCXX::Result1<IndividualAggregator::BatchResult_t> > &result,
+                          const std::string &addressbook,
+                          const std::vector<PersonaDetails> &contacts)
+{
+    try {
+        if (!addressbook.empty()) {
+            SE_THROW("only the system address book is writable");
+        }
+        m_folks->addContacts(createDBusCb(result), contacts);
+    } catch (...) {
+        dbusErrorCallback(result);
+    }
+}
+
+void Manager::modifyContacts(const boost::shared_ptr< GDBusCXX::Result1<IndividualAggregator::BatchResult_t> > &result,
+                             const std::string &addressbook,
+                             const std::vector< std::pair<std::string, PersonaDetails> > &contacts)
+{
+    try {
+        if (!addressbook.empty()) {
+            SE_THROW("only the system address book is writable");
+        }
+        m_folks->modifyContacts(createDBusCb(result), contacts);
+    } catch (...) {
+        dbusErrorCallback(result);
+    }
+}
+
+void Manager::removeContacts(const boost::shared_ptr< GDBusCXX::Result1<IndividualAggregator::BatchResult_t> > &result,
+                             const std::string &addressbook,
+                             const std::vector<std::string> &localIDs)
+{
+    try {
+        if (!addressbook.empty()) {
+            SE_THROW("only the system address book is writable");
+        }
+        m_folks->removeContacts(createDBusCb(result), localIDs);
+    } catch (...) {
+        dbusErrorCallback(result);
+    }
+}
+
 SE_END_CXX
@@ -30,11 +30,13 @@
 #include "../server.h"
 #include "../session.h"
 #include <syncevo/EDSClient.h>
+#include <syncevo/timeout.h>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
 class LocaledListener;
+class ContactSnapshot;
 
 /**
  * Implementation of org._01.pim.contacts.Manager.
@@ -58,6 +60,19 @@ class Manager : public GDBusCXX::DBusObjectHelper
      */
     std::set<std::string> m_enabledEBooks;
 
+    /**
+     * Contacts stored by a previous run, used for searches until
+     * the main view is quiescent. See ContactSnapshot.
+     */
+    boost::shared_ptr<ContactSnapshot> m_snapshot;
+    /** writes a new snapshot once the main view has settled down */
+    Timeout m_snapshotSave;
+    boost::signals2::scoped_connection m_mainViewQuiescence;
+    void mainViewQuiescent();
+    void saveSnapshot();
+    /** write a new snapshot now if one is pending */
+    void flushSnapshot();
+
     typedef std::list< std::pair< boost::shared_ptr<GDBusCXX::Result>, boost::shared_ptr<Session> > > Pending_t;
     /** holds the references to pending session requests, see runInSession() */
     Pending_t m_pending;
@@ -217,6 +232,18 @@ class Manager : public GDBusCXX::DBusObjectHelper
     void removeContact(const boost::shared_ptr<GDBusCXX::Result0> &result,
                        const std::string &addressbook,
                        const std::string &localID);
+    /** Manager.AddContacts() */
+    void addContacts(const boost::shared_ptr< GDBusCXX::Result1<IndividualAggregator::BatchResult_t> > &result,
+                     const std::string &addressbook,
+                     const std::vector<PersonaDetails> &contacts);
+    /** Manager.ModifyContacts() */
+    void modifyContacts(const boost::shared_ptr< GDBusCXX::Result1<IndividualAggregator::BatchResult_t> > &result,
+                        const std::string &addressbook,
+                        const std::vector< std::pair<std::string, PersonaDetails> > &contacts);
+    /** Manager.RemoveContacts() */
+    void removeContacts(const boost::shared_ptr< GDBusCXX::Result1<IndividualAggregator::BatchResult_t> > &result,
+                        const std::string &addressbook,
+                        const std::vector<std::string> &localIDs);
 
  private:
     /**
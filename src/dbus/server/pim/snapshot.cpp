@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+#include "snapshot.h"
+#include <syncevo/util.h>
+#include <syncevo/BoostHelper.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <sstream>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+SE_GOBJECT_TYPE(EdsfPersona);
+SE_GOBJECT_TYPE(EdsfPersonaStore);
+SE_GOBJECT_TYPE(EContact);
+
+SE_BEGIN_CXX
+
+/**
+ * File format: a "syncevolution-pim-snapshot 1\n" header line,
+ * followed by one "<uuid size> <vcard size>\n<uuid><vcard>" entry
+ * per contact.
+ */
+static const char SNAPSHOT_HEADER[] = "syncevolution-pim-snapshot 1\n";
+
+std::string ContactSnapshot::getFilename()
+{
+    return SubstEnvironment("${XDG_CACHE_HOME}/syncevolution/pim-snapshot");
+}
+
+boost::shared_ptr<ContactSnapshot> ContactSnapshot::load(const std::string &filename)
+{
+    boost::shared_ptr<ContactSnapshot> snapshot;
+    std::string content;
+    if (!ReadFile(filename, content) ||
+        !boost::starts_with(content, SNAPSHOT_HEADER)) {
+        return snapshot;
+    }
+
+    boost::shared_ptr<ContactSnapshot> result(new ContactSnapshot);
+    size_t numContacts = 0;
+    size_t off = sizeof(SNAPSHOT_HEADER) - 1;
+    while (off < content.size()) {
+        unsigned long uuidSize, vcardSize;
+        int header;
+        if (sscanf(content.c_str() + off, "%lu %lu\n%n", &uuidSize, &vcardSize, &header) != 2 ||
+            off + header + uuidSize + vcardSize > content.size()) {
+            SE_LOG_DEBUG(NULL, "%s: invalid entry at offset %ld, ignoring snapshot",
+                         filename.c_str(), (long)off);
+            return snapshot;
+        }
+        off += header;
+        result->m_vcards[content.substr(off, uuidSize)].push_back(content.substr(off + uuidSize, vcardSize));
+        off += uuidSize + vcardSize;
+        numContacts++;
+    }
+    SE_LOG_DEBUG(NULL, "%s: %ld contacts from %ld address books",
+                 filename.c_str(), (long)numContacts, (long)result->m_vcards.size());
+    snapshot = result;
+    return snapshot;
+}
+
+void ContactSnapshot::save(IndividualView &view, const std::string &filename)
+{
+    try {
+        std::string tmpname = StringPrintf("%s.%ld", filename.c_str(), (long)getpid());
+        mkdir_p(getDirname(filename));
+        std::ostringstream out;
+        out << SNAPSHOT_HEADER;
+        int numContacts = 0;
+        int size = view.size();
+        for (int index = 0; index < size; index++) {
+            const IndividualData *data = view.getContact(index);
+            if (!data) {
+                continue;
+            }
+            GeeCollCXX<FolksPersona *> personas(folks_individual_get_personas(data->m_individual), ADD_REF);
+            BOOST_FOREACH (FolksPersona *persona, personas) {
+                if (!EDSF_IS_PERSONA(persona)) {
+                    continue;
+                }
+                EContact *contact = edsf_persona_get_contact(EDSF_PERSONA(persona));
+                FolksPersonaStore *store = folks_persona_get_store(persona);
+                if (!contact || !store) {
+                    continue;
+                }
+                const gchar *uuid = folks_persona_store_get_id(store);
+                PlainGStr vcard(e_vcard_to_string(E_VCARD(contact), EVC_FORMAT_VCARD_30));
+                out << (unsigned long)strlen(uuid) << " " << (unsigned long)strlen(vcard.get()) << "\n"
+                    << uuid << vcard.get();
+                numContacts++;
+            }
+        }
+
+        // Contains personal data, keep it private right from the start.
+        unlink(tmpname.c_str());
+        int fd = open(tmpname.c_str(), O_CREAT|O_EXCL|O_WRONLY, S_IRUSR|S_IWUSR);
+        if (fd < 0) {
+            Exception::throwError(SE_HERE, tmpname, errno);
+        }
+        std::string content = out.str();
+        const char *data = content.c_str();
+        size_t remaining = content.size();
+        bool failed = false;
+        while (remaining) {
+            ssize_t written = write(fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                failed = true;
+                break;
+            }
+            data += written;
+            remaining -= written;
+        }
+        if (close(fd)) {
+            failed = true;
+        }
+        if (failed ||
+            rename(tmpname.c_str(), filename.c_str())) {
+            unlink(tmpname.c_str());
+            SE_THROW("writing " + filename + " failed");
+        }
+        SE_LOG_DEBUG(NULL, "%s: stored %d contacts", filename.c_str(), numContacts);
+    } catch (...) {
+        // Not fatal, next startup simply has to wait for folks.
+        Exception::handle(HANDLE_EXCEPTION_NO_ERROR);
+    }
+}
+
+const ContactSnapshot::Individuals_t &ContactSnapshot::getIndividuals(const ESourceRegistryCXX &registry,
+                                                                      const std::string &uuid,
+                                                                      const LocaleFactory *locale)
+{
+    Caches_t::iterator it = m_caches.find(uuid);
+    if (it != m_caches.end() &&
+        it->second->m_locale == locale) {
+        return it->second->m_individuals;
+    }
+
+    std::auto_ptr<Cache> cache(new Cache);
+    cache->m_locale = locale;
+    VCards_t::const_iterator vcards = m_vcards.find(uuid);
+    ESourceCXX source(e_source_registry_ref_source(registry, uuid.c_str()), TRANSFER_REF);
+    if (vcards != m_vcards.end() && source) {
+        // The persona store is only needed for creating personas,
+        // it does not get prepared and therefore does not access
+        // the address book.
+        EdsfPersonaStoreCXX store(edsf_persona_store_new_with_source_registry(registry, source), TRANSFER_REF);
+        cache->m_individuals.reserve(vcards->second.size());
+        BOOST_FOREACH (const std::string &vcard, vcards->second) {
+            EContactCXX contact(e_contact_new_from_vcard(vcard.c_str()), TRANSFER_REF);
+            if (!contact) {
+                continue;
+            }
+            EdsfPersonaCXX persona(edsf_persona_new(store, contact), TRANSFER_REF);
+            GeeHashSetCXX personas(gee_hash_set_new(G_TYPE_OBJECT, g_object_ref, g_object_unref, NULL, NULL, NULL, NULL, NULL, NULL), TRANSFER_REF);
+            gee_collection_add(GEE_COLLECTION(personas.get()), persona.get());
+            FolksIndividualCXX individual(folks_individual_new(GEE_SET(personas.get())), TRANSFER_REF);
+            cache->m_individuals.push_back(new IndividualData);
+            cache->m_individuals.back().init(NULL, locale, individual);
+        }
+    }
+    SE_LOG_DEBUG(NULL, "snapshot %s: created %ld individuals", uuid.c_str(), (long)cache->m_individuals.size());
+    std::string key(uuid);
+    if (it != m_caches.end()) {
+        m_caches.erase(it);
+    }
+    it = m_caches.insert(key, cache).first;
+    return it->second->m_individuals;
+}
+
+SnapshotView::SnapshotView(const ESourceRegistryCXX &registry,
+                           const std::string &uuid,
+                           const boost::shared_ptr<ContactSnapshot> &snapshot,
+                           const boost::shared_ptr<IndividualFilter> &filter,
+                           const boost::shared_ptr<LocaleFactory> &locale) :
+    m_registry(registry),
+    m_uuid(uuid),
+    m_snapshot(snapshot),
+    m_filter(filter),
+    m_locale(locale)
+{
+}
+
+boost::shared_ptr<SnapshotView> SnapshotView::create(const ESourceRegistryCXX &registry,
+                                                     const std::string &uuid,
+                                                     const boost::shared_ptr<ContactSnapshot> &snapshot,
+                                                     const boost::shared_ptr<IndividualFilter> &filter,
+                                                     const boost::shared_ptr<LocaleFactory> &locale)
+{
+    return boost::shared_ptr<SnapshotView>(new SnapshotView(registry, uuid, snapshot, filter, locale));
+}
+
+void SnapshotView::doStart()
+{
+    const ContactSnapshot::Individuals_t &individuals =
+        m_snapshot->getIndividuals(m_registry, m_uuid, m_locale.get());
+    size_t matches = 0;
+    BOOST_FOREACH (const IndividualData &data, individuals) {
+        if (m_filter->matches(data)) {
+            // Report all matches. The snapshot is not sorted,
+            // MergeView sorts and applies the limit, same as for
+            // EDSFView.
+            matches++;
+            m_addedSignal(data.m_individual);
+        }
+    }
+    SE_LOG_DEBUG(NULL, "snapshot %s: %ld matches", m_uuid.c_str(), (long)matches);
+    m_isQuiescent = true;
+    m_quiescenceSignal();
+}
+
+SE_END_CXX
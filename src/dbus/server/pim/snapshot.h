@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+/**
+ * Copy of the EDS contacts in the unified address book, stored on
+ * disk while the unified address book is complete and used after a
+ * restart to answer searches while folks is still loading.
+ * Individuals found that way are based on the EDS contact alone, like
+ * the ones found by EDSFView, and get replaced by MergeView once
+ * folks is done.
+ */
+
+#ifndef INCL_SYNCEVO_DBUS_SERVER_PIM_SNAPSHOT
+#define INCL_SYNCEVO_DBUS_SERVER_PIM_SNAPSHOT
+
+#include "view.h"
+#include "locale-factory.h"
+#include <folks/folks-eds.h>
+#include <syncevo/EDSClient.h>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/ptr_container/ptr_map.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <map>
+
+#include <syncevo/declarations.h>
+SE_BEGIN_CXX
+
+class ContactSnapshot : private boost::noncopyable
+{
+ public:
+    /** ${XDG_CACHE_HOME}/syncevolution/pim-snapshot */
+    static std::string getFilename();
+
+    /**
+     * Read the file written by save(). Returns an empty pointer if
+     * there is no such file or it cannot be parsed.
+     */
+    static boost::shared_ptr<ContactSnapshot> load(const std::string &filename);
+
+    /**
+     * Stores the vCards of all EDS personas in the view. Errors are
+     * logged, but not fatal.
+     */
+    static void save(IndividualView &view, const std::string &filename);
+
+    /** true if the snapshot has contacts from the address book */
+    bool hasAddressBook(const std::string &uuid) const { return m_vcards.find(uuid) != m_vcards.end(); }
+
+    typedef boost::ptr_vector<IndividualData> Individuals_t;
+
+    /**
+     * All contacts of one address book, turned into individuals when
+     * called for the first time. The precomputed search values
+     * are based on the given locale.
+     */
+    const Individuals_t &getIndividuals(const ESourceRegistryCXX &registry,
+                                        const std::string &uuid,
+                                        const LocaleFactory *locale);
+
+ private:
+    typedef std::map<std::string, std::vector<std::string> > VCards_t;
+    /** address book UUID -> vCards */
+    VCards_t m_vcards;
+
+    struct Cache
+    {
+        const LocaleFactory *m_locale;
+        Individuals_t m_individuals;
+    };
+    typedef boost::ptr_map<std::string, Cache> Caches_t;
+    Caches_t m_caches;
+};
+
+/**
+ * Search in the contacts of one address book in a snapshot. Emits
+ * all matching contacts synchronously when started.
+ */
+class SnapshotView : public StreamingView
+{
+    ESourceRegistryCXX m_registry;
+    std::string m_uuid;
+    boost::shared_ptr<ContactSnapshot> m_snapshot;
+    boost::shared_ptr<IndividualFilter> m_filter;
+    boost::shared_ptr<LocaleFactory> m_locale;
+    Bool m_isQuiescent;
+
+    SnapshotView(const ESourceRegistryCXX &registry,
+                 const std::string &uuid,
+                 const boost::shared_ptr<ContactSnapshot> &snapshot,
+                 const boost::shared_ptr<IndividualFilter> &filter,
+                 const boost::shared_ptr<LocaleFactory> &locale);
+
+ public:
+    static boost::shared_ptr<SnapshotView> create(const ESourceRegistryCXX &registry,
+                                                  const std::string &uuid,
+                                                  const boost::shared_ptr<ContactSnapshot> &snapshot,
+                                                  const boost::shared_ptr<IndividualFilter> &filter,
+                                                  const boost::shared_ptr<LocaleFactory> &locale);
+
+    virtual bool isQuiescent() const { return m_isQuiescent; }
+
+ protected:
+    virtual void doStart();
+};
+
+SE_END_CXX
+
+#endif // INCL_SYNCEVO_DBUS_SERVER_PIM_SNAPSHOT
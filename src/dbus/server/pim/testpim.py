@@ -2323,6 +2323,63 @@ END:VCARD''' % {'peer': peer, 'index': index})
              current = active
 
 
+    @timeout(60)
+    def testViewWindow(self):
+        '''TestContacts.testViewWindow - restrict view to a window and move it'''
+        self.setUpView()
+
+        for index in range(0, 5):
+             item = os.path.join(self.contacts, 'contact%d.vcf' % index)
+             output = open(item, "w")
+             output.write('''BEGIN:VCARD
+VERSION:3.0
+FN:John_%(index)d Doe
+N:Doe;John_%(index)d
+END:VCARD''' % {'index': index})
+             output.close()
+        logging.log('inserting contacts')
+        out, err, returncode = self.runCmdline(['--import', self.contacts, '@' + self.managerPrefix + self.uid, 'local'])
+        self.runUntil('view with five contacts',
+                      check=lambda: self.assertEqual([], self.view.errors),
+                      until=lambda: len(self.view.contacts) == 5)
+        ids = self.view.getIDs(0, 5)
+
+        def setWindow(start, count):
+             quiescentCount = self.view.quiescentCount
+             self.view.events = []
+             self.view.view.SetWindow(start, count)
+             self.runUntil('window #%d + %d' % (start, count),
+                           check=lambda: self.assertEqual([], self.view.errors),
+                           until=lambda: self.view.quiescentCount > quiescentCount)
+
+        # Only #1 and #2.
+        setWindow(1, 2)
+        self.assertEqual(ids[1:3], self.view.getIDs(0, 5))
+
+        # Scrolling by one only moves one contact.
+        setWindow(2, 2)
+        self.assertEqual(ids[2:4], self.view.getIDs(0, 5))
+        self.assertEqual([('removed', 0, 1),
+                          ('added', 1, 1),
+                          ('quiescent',)],
+                         self.view.events)
+
+        # Indices in ReadContacts() are relative to the window.
+        self.view.read(0, 2)
+        self.runUntil('window contacts',
+                      check=lambda: self.assertEqual([], self.view.errors),
+                      until=lambda: self.view.haveData(0, 2))
+        self.assertEqual(u'John_2', self.view.contacts[0]['structured-name']['given'])
+        self.assertEqual(u'John_3', self.view.contacts[1]['structured-name']['given'])
+
+        # Window behind the end of the view is empty.
+        setWindow(10, 2)
+        self.assertEqual([], self.view.getIDs(0, 5))
+
+        # Back to the entire view.
+        setWindow(0, -1)
+        self.assertEqual(ids, self.view.getIDs(0, 5))
+
     @timeout(60)
     @property("ENV", "LC_TYPE=de_DE.UTF-8 LC_ALL=de_DE.UTF-8 LANG=de_DE.UTF-8")
     def testFilterExisting(self):
@@ -4088,6 +4145,64 @@ END:VCARD''']):
                       check=lambda: self.assertEqual([], self.view.errors),
                       until=lambda: len(self.view.contacts) == 0)
 
+    @timeout(60)
+    @property("snapshot", "simple-sort")
+    def testContactWriteBatch(self):
+        '''TestContacts.testContactWriteBatch - add, update and remove several contacts with one call'''
+        self.setUpView(peers=[], withSystemAddressBook=True)
+
+        with self.assertRaisesRegexp(dbus.DBusException,
+                                     r'.*: only the system address book is writable'):
+             self.manager.AddContacts('no-such-address-book',
+                                      [{'full-name': 'John Doe'}])
+
+        # Add new contacts.
+        names = [ 'Contact %02d' % i for i in range(10) ]
+        results = self.manager.AddContacts('',
+                                           [ {'full-name': name} for name in names ])
+        self.assertEqual(len(names), len(results))
+        for localID, error in results:
+             self.assertEqual('', error)
+             self.assertNotEqual('', localID)
+        localIDs = [ localID for localID, error in results ]
+
+        self.runUntil('view with contacts',
+                      check=lambda: self.assertEqual([], self.view.errors),
+                      until=lambda: len(self.view.contacts) == len(names))
+        self.view.read(0, len(names))
+        self.runUntil('contact data',
+                      check=lambda: self.assertEqual([], self.view.errors),
+                      until=lambda: self.view.haveData(0, len(names)))
+        self.assertEqual(names, [ contact['full-name'] for contact in self.view.contacts ])
+
+        # Update the contacts, including one which does not exist.
+        # Only that one fails.
+        results = self.manager.ModifyContacts('',
+                                              [ (localID, {'full-name': 'Modified %02d' % i})
+                                                for i, localID in enumerate(localIDs) ] +
+                                              [ ('no-such-local-id', {'full-name': 'nobody'}) ])
+        self.assertEqual(len(names) + 1, len(results))
+        self.assertEqual([ (localID, '') for localID in localIDs ],
+                         results[:-1])
+        self.assertEqual('no-such-local-id', results[-1][0])
+        self.assertRegexpMatches(results[-1][1],
+                                 r'''contact with local ID 'no-such-local-id' not found in system address book''')
+        start = time.time()
+        self.runUntil('modified contact data',
+                      check=lambda: (self.assertEqual([], self.view.errors),
+                                     self.view.haveData(0, len(names)) or self.view.read(0, len(names)) or True),
+                      until=lambda: self.view.haveData(0, len(names)) and time.time() - start > 5)
+        self.assertEqual([ 'Modified %02d' % i for i in range(len(names)) ],
+                         [ contact['full-name'] for contact in self.view.contacts ])
+
+        # Remove the contacts.
+        results = self.manager.RemoveContacts('', localIDs)
+        self.assertEqual([ (localID, '') for localID in localIDs ],
+                         results)
+        self.runUntil('empty view',
+                      check=lambda: self.assertEqual([], self.view.errors),
+                      until=lambda: len(self.view.contacts) == 0)
+
     # TODO: check that deleting or modifying a contact works directly
     # after starting the PIM manager. The problem is that FolksPersonaStore
     # might still be loading the contacts, in which case looking up the
@@ -4359,6 +4474,46 @@ END:VCARD''']):
                   ],
                          self.view.events)
 
+    @timeout(int(os.environ.get('TESTPIM_TEST_PHONE_NUM', 100)) / 100 * (usingValgrind() and 20 or 2) + 60)
+    def testFilterPhoneMany(self):
+        '''TestContacts.testFilterPhoneMany - caller ID lookup among TESTPIM_TEST_PHONE_NUM contacts (default 100)'''
+        contactsTotal = int(os.environ.get('TESTPIM_TEST_PHONE_NUM', 100))
+        withLogging = (contactsTotal <= 100)
+        self.setUpView(search=None, withLogging=withLogging)
+
+        # Each contact has a different phone number.
+        for index in range(0, contactsTotal):
+             item = os.path.join(self.contacts, 'john%d.vcf' % index)
+             output = open(item, "w")
+             output.write('''BEGIN:VCARD
+VERSION:3.0
+FN:John_%(index)06d Doe
+N:Doe;John_%(index)06d
+TEL:+49-89-%(number)d
+END:VCARD''' % {'index': index, 'number': 1000000 + index})
+             output.close()
+        logging.log('inserting data')
+        out, err, returncode = self.runCmdline(['--import', self.contacts, '@' + self.managerPrefix + self.uid, 'local'])
+
+        # Wait until the unified address book has all contacts.
+        self.view.search('')
+        self.runUntil('view with contacts',
+                      check=lambda: self.assertEqual([], self.view.errors),
+                      until=lambda: len(self.view.contacts) == contactsTotal,
+                      may_block=not withLogging)
+
+        # Look up first, middle, last and a non-existent number.
+        for index in [0, contactsTotal / 2, contactsTotal - 1, contactsTotal]:
+             view = ContactsView(self.manager)
+             start = time.time()
+             view.search([['phone', '+4989%d' % (1000000 + index)]])
+             self.runUntil('phone results',
+                           check=lambda: self.assertEqual([], view.errors),
+                           until=lambda: view.quiescentCount > 0)
+             duration = time.time() - start
+             logging.printf('caller ID lookup #%d among %d contacts: %fs', index, contactsTotal, duration)
+             self.assertEqual(index < contactsTotal and 1 or 0, len(view.contacts))
+
     @timeout(60)
     def testDeadAgent(self):
         '''TestContacts.testDeadAgent - an error from the agent kills the view'''
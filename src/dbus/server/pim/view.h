@@ -142,6 +142,14 @@ class IndividualView : public View
     /** returns access to one individual or an empty pointer if outside of the current range */
     virtual const IndividualData *getContact(int index) = 0;
 
+    /**
+     * Finds the indices of all individuals with a precomputed phone
+     * number that has the given national number, in increasing
+     * order. Returns false if the view cannot do that faster than
+     * checking all individuals.
+     */
+    virtual bool findNationalNumber(SimpleE164::NationalNumber_t number, std::vector<int> &indices) { return false; }
+
  protected:
     void findContact(const std::string &id, int hint, int &index, FolksIndividualCXX &individual);
 };
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+#include "window-view.h"
+#include <syncevo/BoostHelper.h>
+
+#include <syncevo/declarations.h>
+SE_BEGIN_CXX
+
+WindowView::WindowView(const boost::shared_ptr<IndividualView> &parent) :
+    m_parent(parent),
+    m_start(0),
+    m_count(-1),
+    m_size(0)
+{
+    setName("window view");
+}
+
+void WindowView::init(const boost::shared_ptr<WindowView> &self)
+{
+    m_self = self;
+
+    // The parent might have content already (persistent full view).
+    // Track it right away, so that size() and getContact() are
+    // valid before starting.
+    m_size = targetSize();
+    m_parent->m_quiescenceSignal.connect(QuiescenceSignal_t::slot_type(boost::ref(m_quiescenceSignal)).track(m_self));
+    m_parent->m_addedSignal.connect(ChangeSignal_t::slot_type(boost::bind(&WindowView::addIndividual, this, _1, _2)).track(m_self));
+    m_parent->m_modifiedSignal.connect(ChangeSignal_t::slot_type(boost::bind(&WindowView::modifyIndividual, this, _1, _2)).track(m_self));
+    m_parent->m_removedSignal.connect(ChangeSignal_t::slot_type(boost::bind(&WindowView::removeIndividual, this, _1, _2)).track(m_self));
+}
+
+boost::shared_ptr<WindowView> WindowView::create(const boost::shared_ptr<IndividualView> &parent)
+{
+    boost::shared_ptr<WindowView> view(new WindowView(parent));
+    view->init(view);
+    return view;
+}
+
+void WindowView::doStart()
+{
+    m_parent->start();
+}
+
+int WindowView::targetSize() const
+{
+    int available = std::max(0, m_parent->size() - m_start);
+    return m_count == -1 ?
+        available :
+        std::min(available, m_count);
+}
+
+void WindowView::fillWindow()
+{
+    int target = targetSize();
+    while (m_size < target) {
+        m_size++;
+        m_addedSignal(m_size - 1, *m_parent->getContact(m_start + m_size - 1));
+    }
+}
+
+void WindowView::addIndividual(int parentIndex, const IndividualData &data)
+{
+    if (parentIndex < m_start) {
+        // Shifts the entry in front of the window into it.
+        if (m_parent->size() > m_start) {
+            m_size++;
+            m_addedSignal(0, *m_parent->getContact(m_start));
+        }
+    } else if (parentIndex <= m_start + m_size &&
+               (m_count == -1 || parentIndex - m_start < m_count)) {
+        m_size++;
+        m_addedSignal(parentIndex - m_start, data);
+    } else {
+        // Behind the window.
+        return;
+    }
+
+    // Drop entry which was pushed out at the end.
+    if (m_count != -1 && m_size > m_count) {
+        m_size--;
+        m_removedSignal(m_size, *m_parent->getContact(m_start + m_size));
+    }
+}
+
+void WindowView::removeIndividual(int parentIndex, const IndividualData &data)
+{
+    if (parentIndex < m_start) {
+        // Shifts the first entry out of the window. It is
+        // now in front of the window.
+        if (m_size) {
+            m_size--;
+            m_removedSignal(0, *m_parent->getContact(m_start - 1));
+        }
+    } else if (parentIndex < m_start + m_size) {
+        m_size--;
+        m_removedSignal(parentIndex - m_start, data);
+    } else {
+        return;
+    }
+
+    // Entry behind the window moves into it.
+    fillWindow();
+}
+
+void WindowView::modifyIndividual(int parentIndex, const IndividualData &data)
+{
+    if (parentIndex >= m_start &&
+        parentIndex < m_start + m_size) {
+        m_modifiedSignal(parentIndex - m_start, data);
+    }
+}
+
+void WindowView::setWindow(int start, int count)
+{
+    if (start < 0 || count < -1) {
+        SE_THROW(StringPrintf("invalid window: start %d, count %d", start, count));
+    }
+    SE_LOG_DEBUG(NULL, "%s: window #%d + %d -> #%d + %d",
+                 getName(),
+                 m_start, m_size,
+                 start, count);
+
+    if (!m_size ||
+        start >= m_start + m_size ||
+        (count != -1 && start + count <= m_start)) {
+        // Nothing is kept, start from scratch.
+        while (m_size) {
+            m_size--;
+            m_start++;
+            m_removedSignal(0, *m_parent->getContact(m_start - 1));
+        }
+        m_start = start;
+    }
+
+    // Move start of window, keeping the overlapping entries.
+    while (m_start < start) {
+        m_size--;
+        m_start++;
+        m_removedSignal(0, *m_parent->getContact(m_start - 1));
+    }
+    while (m_start > start) {
+        m_size++;
+        m_start--;
+        m_addedSignal(0, *m_parent->getContact(m_start));
+    }
+
+    // Adjust end of window.
+    m_count = count;
+    int target = targetSize();
+    while (m_size > target) {
+        m_size--;
+        m_removedSignal(m_size, *m_parent->getContact(m_start + m_size));
+    }
+    fillWindow();
+
+    if (isQuiescent()) {
+        m_quiescenceSignal();
+    }
+}
+
+SE_END_CXX
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+#ifndef INCL_SYNCEVO_DBUS_SERVER_PIM_WINDOW_VIEW
+#define INCL_SYNCEVO_DBUS_SERVER_PIM_WINDOW_VIEW
+
+#include "view.h"
+
+#include <syncevo/declarations.h>
+SE_BEGIN_CXX
+
+/**
+ * A consecutive range of entries in some other view, for example
+ * the rows that a UI currently shows. Index #0 is the entry at the
+ * start of the window in the parent view. Changes in the parent view
+ * outside of the window only cause signals if they shift entries
+ * into or out of the window.
+ *
+ * By default the window covers the entire parent view.
+ */
+class WindowView : public IndividualView
+{
+    boost::weak_ptr<WindowView> m_self;
+    boost::shared_ptr<IndividualView> m_parent;
+
+    /** index of the first entry in the parent */
+    int m_start;
+
+    /** maximum number of entries, -1 for unlimited */
+    int m_count;
+
+    /**
+     * Current number of entries. Entries #0 till #m_size - 1 are
+     * entries #m_start till #m_start + m_size - 1 in the parent.
+     */
+    int m_size;
+
+    WindowView(const boost::shared_ptr<IndividualView> &parent);
+    void init(const boost::shared_ptr<WindowView> &self);
+
+    /** number of entries that the window should have */
+    int targetSize() const;
+
+    /** add entries at the end until the window is full */
+    void fillWindow();
+
+    void addIndividual(int parentIndex, const IndividualData &data);
+    void removeIndividual(int parentIndex, const IndividualData &data);
+    void modifyIndividual(int parentIndex, const IndividualData &data);
+
+ public:
+    static boost::shared_ptr<WindowView> create(const boost::shared_ptr<IndividualView> &parent);
+
+    /**
+     * Move or resize the window. Entries which remain inside the
+     * window are not reported again, so scrolling by a few entries
+     * only causes a few signals.
+     *
+     * @param start    index of the first entry in the parent, >= 0
+     * @param count    maximum number of entries, -1 for unlimited
+     */
+    void setWindow(int start, int count);
+
+    /**
+     * Mirrors the quiesent state of the underlying view.
+     */
+    virtual bool isQuiescent() const { return m_parent->isQuiescent(); }
+
+    // from IndividualView
+    virtual void doStart();
+    virtual void replaceFilter(const boost::shared_ptr<IndividualFilter> &individualFilter,
+                               bool refine) { m_parent->replaceFilter(individualFilter, refine); }
+    virtual int size() const { return m_size; }
+    virtual const IndividualData *getContact(int index) { return (index >= 0 && index < m_size) ? m_parent->getContact(m_start + index) : NULL; }
+};
+
+SE_END_CXX
+
+#endif // INCL_SYNCEVO_DBUS_SERVER_PIM_WINDOW_VIEW
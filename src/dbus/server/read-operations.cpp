@@ -238,41 +238,38 @@ void ReadOperations::getReports(uint32_t start, uint32_t count,
 {
     SyncContext client(m_configName, false);
     std::vector<string> dirs;
-    client.getSessions(dirs);
-
-    uint32_t index = 0;
-    // newest report firstly
-    for( int i = dirs.size() - 1; i >= 0; --i) {
-        /** if start plus count is bigger than actual size, then return actual - size reports */
-        if(index >= start && index - start < count) {
-            const string &dir = dirs[i];
-            std::map<string, string> aReport;
-            // insert a 'dir' as an ID for the current report
-            aReport.insert(pair<string, string>("dir", dir));
-            SyncReport report;
-            // peerName is also extracted from the dir
-            string peerName = client.readSessionInfo(dir,report);
-            boost::shared_ptr<SyncConfig> config(new SyncConfig(m_configName));
-            string storedPeerName = config->getPeerName();
-            //if can't find peer name, use the peer name from the log dir
-            if(!storedPeerName.empty()) {
-                peerName = storedPeerName;
-            }
+    std::vector<string> peerNames;
+    std::vector<SyncReport> sessionReports;
+    // newest report firstly; if start plus count is bigger than
+    // actual size, then return actual - size reports
+    client.readSessionInfos(start, count, dirs, peerNames, sessionReports);
+
+    boost::shared_ptr<SyncConfig> config(new SyncConfig(m_configName));
+    string storedPeerName = config->getPeerName();
+    for (size_t i = 0; i < dirs.size(); i++) {
+        const string &dir = dirs[i];
+        std::map<string, string> aReport;
+        // insert a 'dir' as an ID for the current report
+        aReport.insert(pair<string, string>("dir", dir));
+        // peerName is also extracted from the dir
+        string peerName = peerNames[i];
+        //if can't find peer name, use the peer name from the log dir
+        if(!storedPeerName.empty()) {
+            peerName = storedPeerName;
+        }
 
-            /** serialize report to ConfigProps and then copy them to reports */
-            IniHashConfigNode node("/dev/null","",true);
-            node << report;
-            ConfigProps props;
-            node.readProperties(props);
+        /** serialize report to ConfigProps and then copy them to reports */
+        IniHashConfigNode node("/dev/null","",true);
+        node << sessionReports[i];
+        ConfigProps props;
+        node.readProperties(props);
 
-            BOOST_FOREACH(const ConfigProps::value_type &entry, props) {
-                aReport.insert(entry);
-            }
-            // a new key-value pair <"peer", [peer name]> is transferred
-            aReport.insert(pair<string, string>("peer", peerName));
-            reports.push_back(aReport);
+        BOOST_FOREACH(const ConfigProps::value_type &entry, props) {
+            aReport.insert(entry);
         }
-        index++;
+        // a new key-value pair <"peer", [peer name]> is transferred
+        aReport.insert(pair<string, string>("peer", peerName));
+        reports.push_back(aReport);
     }
 }
 
@@ -33,6 +33,7 @@
 #include "restart.h"
 #include "client.h"
 #include "auto-sync-manager.h"
+#include "helper-pool.h"
 #include "connman-client.h"
 #include "network-manager-client.h"
 #include "presence-status.h"
@@ -177,6 +178,7 @@ vector<string> Server::getCapabilities()
     capabilities.push_back("SessionFlags");
     capabilities.push_back("SessionAttach");
     capabilities.push_back("DatabaseProperties");
+    capabilities.push_back("SuppressedSignals");
     return capabilities;
 }
 
@@ -190,6 +192,13 @@ StringMap Server::getVersions()
     return versions;
 }
 
+std::map<std::string, uint32_t> Server::getSuppressedSignals()
+{
+    std::map<std::string, uint32_t> suppressed;
+    suppressed["LogOutput"] = getSuppressedLogOutput();
+    return suppressed;
+}
+
 void Server::attachClient(const Caller_t &caller,
                           const boost::shared_ptr<Watch> &watch)
 {
@@ -367,6 +376,7 @@ Server::Server(GMainLoop *loop,
     configChanged(*this, "ConfigChanged"),
     infoRequest(*this, "InfoRequest"),
     m_logOutputSignal(*this, "LogOutput"),
+    m_logOutputThrottle(1000, boost::bind(&Server::flushLogOutput, this)),
     m_autoTerm(m_loop, m_shutdownRequested, duration),
     m_dbusLogLevel(Logger::INFO),
     // TODO (?): turn Server into a proper reference counted instance.
@@ -380,6 +390,7 @@ Server::Server(GMainLoop *loop,
     srand(tv.tv_usec);
     add(this, &Server::getCapabilities, "GetCapabilities");
     add(this, &Server::getVersions, "GetVersions");
+    add(this, &Server::getSuppressedSignals, "GetSuppressedSignals");
     add(this, &Server::attachClient, "Attach");
     add(this, &Server::detachClient, "Detach");
     add(this, &Server::enableNotifications, "EnableNotifications");
@@ -403,6 +414,16 @@ Server::Server(GMainLoop *loop,
     add(infoRequest);
     add(m_logOutputSignal);
 
+    // see SYNCEVOLUTION_DBUS_LOG_RATE in README.rst
+    const char *rate = getenv("SYNCEVOLUTION_DBUS_LOG_RATE");
+    int maxLogOutput = rate ? atoi(rate) : 1000;
+    m_logOutputThrottle.setMutex(&m_logOutputMutex);
+    if (maxLogOutput > 0) {
+        m_logOutputThrottle.setBurst(maxLogOutput);
+    } else {
+        m_logOutputThrottle.setInterval(0);
+    }
+
     // Log entering and leaving idle state and
     // allow/prevent auto-termination.
     m_idleSignal.connect(boost::bind(&Server::onIdleChange, this, _1));
@@ -464,6 +485,12 @@ void Server::activate()
 
     // create auto sync manager, now that server is ready
     m_autoSync = AutoSyncManager::createAutoSyncManager(*this);
+
+    // Keep helpers ready for sessions if requested.
+    const char *poolSize = getenv("SYNCEVOLUTION_HELPER_POOL");
+    if (poolSize && atoi(poolSize) > 0) {
+        m_helperPool.reset(new HelperPool(*this, atoi(poolSize)));
+    }
 }
 
 Server::~Server()
@@ -476,6 +503,7 @@ Server::~Server()
     m_workQueue.clear();
     m_clients.clear();
     m_autoSync.reset();
+    m_helperPool.reset();
     m_infoReqMap.clear();
     m_timeouts.clear();
     m_delayDeletion.clear();
@@ -484,6 +512,8 @@ Server::~Server()
     m_presence.reset();
 
     m_pushLogger.reset();
+    SE_LOG_DEBUG(NULL, "%ld LogOutput signals suppressed because of rate limiting",
+                 (long)getSuppressedLogOutput());
     m_logger.reset();
 }
 
@@ -515,6 +545,11 @@ void Server::fileModified(const std::string &file)
                  m_shutdownTimer ? "timer already active" : "timer not yet active",
                  m_activeSession ? "waiting for active session to finish" : "setting timer");
     m_lastFileMod = Timespec::monotonic();
+    if (m_helperPool) {
+        // Idle helpers were started with the old files and new
+        // ones would not match the running server.
+        m_helperPool->drain();
+    }
     if (!m_activeSession) {
         m_shutdownTimer.activate(SHUTDOWN_QUIESENCE_SECONDS,
                                  boost::bind(&Server::shutdown, this));
@@ -1076,9 +1111,31 @@ void Server::logOutput(const GDBusCXX::DBusObject_t &path,
                        const std::string &procname)
 {
     if (level <= m_dbusLogLevel) {
+        DynMutex::Guard guard = m_logOutputMutex.lock();
+        size_t unflushed = m_logOutputThrottle.getUnflushed();
+        if (!m_logOutputThrottle.check(level <= Logger::ERROR)) {
+            return;
+        }
+        if (unflushed) {
+            m_logOutputSignal(getPath(), Logger::levelToStr(Logger::INFO),
+                              StringPrintf("%ld log messages not sent via D-Bus because of rate limiting", (long)unflushed),
+                              Logger::getProcessName());
+        }
         string strLevel = Logger::levelToStr(level);
         m_logOutputSignal(path, strLevel, explanation, procname);
     }
 }
 
+void Server::flushLogOutput()
+{
+    DynMutex::Guard guard = m_logOutputMutex.lock();
+    size_t unflushed = m_logOutputThrottle.getUnflushed();
+    if (unflushed &&
+        m_logOutputThrottle.check(true)) {
+        m_logOutputSignal(getPath(), Logger::levelToStr(Logger::INFO),
+                          StringPrintf("%ld log messages not sent via D-Bus because of rate limiting", (long)unflushed),
+                          Logger::getProcessName());
+    }
+}
+
 SE_END_CXX
@@ -33,6 +33,7 @@
 #include "auto-term.h"
 #include "dbus-callbacks.h"
 #include "read-operations.h"
+#include "signal-throttle.h"
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
@@ -49,6 +50,7 @@ class AutoSyncManager;
 class PresenceStatus;
 class ConnmanClient;
 class NetworkManagerClient;
+class HelperPool;
 
 // TODO: avoid polluting namespace
 using namespace std;
@@ -185,6 +187,9 @@ class Server : public GDBusCXX::DBusObjectHelper
     /** Server.GetVersions() */
     StringMap getVersions();
 
+    /** Server.GetSuppressedSignals() */
+    std::map<std::string, uint32_t> getSuppressedSignals();
+
     /** Server.Attach() */
     void attachClient(const GDBusCXX::Caller_t &caller,
                       const boost::shared_ptr<GDBusCXX::Watch> &watch);
@@ -360,9 +365,25 @@ class Server : public GDBusCXX::DBusObjectHelper
                    const std::string &explanation,
                    const std::string &procname);
 
+    /**
+     * Number of LogOutput signals which were not sent because of
+     * rate limiting, see SYNCEVOLUTION_DBUS_LOG_RATE.
+     */
+    size_t getSuppressedLogOutput()
+    {
+        DynMutex::Guard guard = m_logOutputMutex.lock();
+        return m_logOutputThrottle.getSuppressed();
+    }
+
     void setDBusLogLevel(Logger::Level level) { m_dbusLogLevel = level; }
     Logger::Level getDBusLogLevel() const { return m_dbusLogLevel; }
 
+    /**
+     * Pre-started helpers which sessions may claim instead of
+     * starting their own, NULL if disabled.
+     */
+    HelperPool *getHelperPool() { return m_helperPool.get(); }
+
  private:
     /** Server.LogOutput */
     GDBusCXX::EmitSignal4<const GDBusCXX::DBusObject_t &,
@@ -370,6 +391,16 @@ class Server : public GDBusCXX::DBusObjectHelper
                           const std::string &,
                           const std::string &> m_logOutputSignal;
 
+    /**
+     * Limits the number of LogOutput signals per second. Protected
+     * by m_logOutputMutex because logging may happen in any thread.
+     */
+    SignalThrottle m_logOutputThrottle;
+    DynMutex m_logOutputMutex;
+
+    /** tell clients how many LogOutput signals were suppressed */
+    void flushLogOutput();
+
     friend class InfoReq;
 
     /** emit InfoRequest */
@@ -388,6 +419,9 @@ class Server : public GDBusCXX::DBusObjectHelper
     /** Manager to automatic sync */
     boost::shared_ptr<AutoSyncManager> m_autoSync;
 
+    /** see SYNCEVOLUTION_HELPER_POOL */
+    boost::scoped_ptr<HelperPool> m_helperPool;
+
     //automatic termination
     AutoTerm m_autoTerm;
 
@@ -152,6 +152,53 @@ namespace GDBusCXX {
         > > > > > > > > > > > > >
         {};
 
+#ifdef GDBUS_CXX_GIO
+    /**
+     * Deleter for a SharedBuffer which references memory owned by
+     * someone else, for example a D-Bus message. Frees nothing
+     * itself, only releases the owner together with the buffer.
+     */
+    struct SharedBufferOwner
+    {
+        boost::shared_ptr<const void> m_owner;
+        SharedBufferOwner(const boost::shared_ptr<const void> &owner) : m_owner(owner) {}
+        void operator () (char *) const {}
+    };
+
+    /**
+     * Same encoding as DBusArray<uint8_t>, but the SharedBuffer
+     * references the bytes inside the D-Bus message instead of
+     * copying them when decoding, and the message references the
+     * SharedBuffer when encoding. SharedBuffer does ref counting for
+     * the memory chunk, so copying it is cheap.
+     */
+    template <> struct dbus_traits<SharedBuffer> :
+        public dbus_traits< DBusSharedArray<uint8_t> >
+    {
+        typedef dbus_traits< DBusSharedArray<uint8_t> > base;
+
+        typedef SharedBuffer host_type;
+        typedef const SharedBuffer &arg_type;
+
+        static void get(GDBusCXX::ExtractArgs &context,
+                        GDBusCXX::reader_type &iter, host_type &buffer)
+        {
+            base::host_type array;
+            base::get(context, iter, array);
+            buffer = SharedBuffer(const_cast<char *>(reinterpret_cast<const char *>(array.second)),
+                                  array.first,
+                                  SharedBufferOwner(array.getOwner()));
+        }
+
+        static void append(GDBusCXX::builder_type &builder, arg_type buffer)
+        {
+            base::host_type array(buffer.size(),
+                                  reinterpret_cast<const uint8_t *>(buffer.get()),
+                                  boost::shared_ptr<const void>(new SharedBuffer(buffer)));
+            base::append(builder, array);
+        }
+    };
+#else
     /**
      * Similar to DBusArray<uint8_t>, but with different native
      * types. Uses encoding/decoding from the base class, copies
@@ -171,15 +218,6 @@ namespace GDBusCXX {
         typedef SharedBuffer host_type;
         typedef const SharedBuffer &arg_type;
 
-#ifdef GDBUS_CXX_GIO
-        static void get(GDBusCXX::ExtractArgs &context,
-                        GDBusCXX::reader_type &iter, host_type &buffer)
-        {
-            base::host_type array;
-            base::get(context, iter, array);
-            buffer = SharedBuffer(reinterpret_cast<const char *>(array.second), array.first);
-        }
-#else
         static void get(GDBusCXX::connection_type *conn, GDBusCXX::message_type *msg,
                         GDBusCXX::reader_type &iter, host_type &buffer)
         {
@@ -187,7 +225,6 @@ namespace GDBusCXX {
             base::get(conn, msg, iter, array);
             buffer = SharedBuffer(reinterpret_cast<const char *>(array.second), array.first);
         }
-#endif
 
         static void append(GDBusCXX::builder_type &builder, arg_type buffer)
         {
@@ -195,83 +232,7 @@ namespace GDBusCXX {
             base::append(builder, array);
         }
     };
-
-    template <> struct dbus_traits<SyncReport> :
-        public dbus_traits< std::string >
-    {
-        typedef dbus_traits< std::string > base;
-
-        typedef SyncReport host_type;
-        typedef const SyncReport &arg_type;
-
-#ifdef GDBUS_CXX_GIO
-        static void get(GDBusCXX::ExtractArgs &context,
-                        GDBusCXX::reader_type &iter, host_type &report)
-        {
-            std::string dump;
-            base::get(context, iter, dump);
-            report = SyncReport(dump);
-        }
-#else
-        static void get(GDBusCXX::connection_type *conn, GDBusCXX::message_type *msg,
-                        GDBusCXX::reader_type &iter, host_type &report)
-        {
-            std::string dump;
-            base::get(conn, msg, iter, dump);
-            report = SyncReport(dump);
-        }
 #endif
-
-        static void append(GDBusCXX::builder_type &builder, arg_type report)
-        {
-            base::append(builder, report.toString());
-        }
-    };
-
-    template <> struct dbus_traits<SyncSourceReport> :
-        public dbus_traits< std::string >
-    {
-        typedef dbus_traits< std::string > base;
-
-        typedef SyncSourceReport host_type;
-        typedef const SyncSourceReport &arg_type;
-
-#ifdef GDBUS_CXX_GIO
-        static void get(GDBusCXX::ExtractArgs &context,
-                        GDBusCXX::reader_type &iter, host_type &source)
-        {
-            std::string dump;
-            base::get(context, iter, dump);
-            SyncReport report = SyncReport(dump);
-            const SyncSourceReport *foo = report.findSyncSourceReport("foo");
-            if (!foo) {
-                SE_THROW("incomplete SyncReport");
-            }
-            source = *foo;
-        }
-#else
-        static void get(GDBusCXX::connection_type *conn, GDBusCXX::message_type *msg,
-                        GDBusCXX::reader_type &iter, host_type &source)
-        {
-            std::string dump;
-            base::get(conn, msg, iter, dump);
-            SyncReport report = SyncReport(dump);
-            const SyncSourceReport *foo = report.findSyncSourceReport("foo");
-            if (!foo) {
-                SE_THROW("incomplete SyncReport");
-            }
-            source = *foo;
-        }
-#endif
-
-        static void append(GDBusCXX::builder_type &builder, arg_type source)
-        {
-            SyncReport report;
-            report.addSyncSourceReport("foo", source);
-            base::append(builder, report.toString());
-        }
-    };
-
 }
 
 #endif // SESSION_COMMON_H
@@ -137,12 +137,15 @@ class SessionHelper : public GDBusCXX::DBusObjectHelper,
     /** tell parent's connection to shut down */
     GDBusCXX::EmitSignal0Template<false> emitShutdown;
 
-    /** store the next message received by the session's connection */
-    void storeMessage(const GDBusCXX::DBusArray<uint8_t> &message,
+    /**
+     * store the next message received by the session's connection,
+     * references the bytes in the D-Bus message without copying them
+     */
+    void storeMessage(const SharedBuffer &message,
                       const std::string &type) {
         m_messageSignal(message, type);
     }
-    typedef boost::signals2::signal<void (const GDBusCXX::DBusArray<uint8_t> &,
+    typedef boost::signals2::signal<void (const SharedBuffer &,
                                           const std::string &)> MessageSignal_t;
     MessageSignal_t m_messageSignal;
 
@@ -26,6 +26,7 @@
 #include "session-common.h"
 #include "dbus-callbacks.h"
 #include "presence-status.h"
+#include "helper-pool.h"
 
 #include <syncevo/ForkExec.h>
 #include <syncevo/SyncContext.h>
@@ -569,6 +570,14 @@ void Session::getAPIProgress(int32_t &progress,
     sources = m_sourceProgress;
 }
 
+std::map<std::string, uint32_t> Session::getSuppressedSignals()
+{
+    std::map<std::string, uint32_t> suppressed;
+    suppressed["StatusChanged"] = m_statusThrottle.getSuppressed();
+    suppressed["ProgressChanged"] = m_progressThrottle.getSuppressed();
+    return suppressed;
+}
+
 void Session::getProgress(int32_t &progress,
                           SourceProgresses_t &sources)
 {
@@ -595,11 +604,10 @@ void Session::fireStatus(bool flush)
     uint32_t error;
     SourceStatuses_t sources;
 
-    /** not force flushing and not timeout, return */
-    if(!flush && !m_statusTimer.timeout()) {
+    /** not force flushing and too soon after the last signal, return */
+    if (!m_statusThrottle.check(flush)) {
         return;
     }
-    m_statusTimer.reset();
 
     getStatus(status, error, sources);
     m_statusSignal(status, error, sources);
@@ -611,11 +619,10 @@ void Session::fireProgress(bool flush)
     int32_t progress;
     SourceProgresses_t sources;
 
-    /** not force flushing and not timeout, return */
-    if(!flush && !m_progressTimer.timeout()) {
+    /** not force flushing and too soon after the last signal, return */
+    if (!m_progressThrottle.check(flush)) {
         return;
     }
-    m_progressTimer.reset();
 
     getProgress(progress, sources);
     m_progressSignal(progress, sources);
@@ -664,8 +671,8 @@ Session::Session(Server &server,
     m_error(0),
     m_lastProgressTimestamp(Timespec::monotonic()),
     m_freeze(false),
-    m_statusTimer(100),
-    m_progressTimer(50),
+    m_statusThrottle(100, boost::bind(&Session::fireStatus, this, true)),
+    m_progressThrottle(50, boost::bind(&Session::fireProgress, this, true)),
     m_restoreSrcTotal(0),
     m_restoreSrcEnd(0),
     m_runOperation(SessionCommon::OP_NULL),
@@ -690,6 +697,7 @@ Session::Session(Server &server,
     add(this, &Session::suspend, "Suspend");
     add(this, &Session::getStatus, "GetStatus");
     add(this, &Session::getAPIProgress, "GetProgress");
+    add(this, &Session::getSuppressedSignals, "GetSuppressedSignals");
     add(this, &Session::restore, "Restore");
     add(this, &Session::checkPresence, "CheckPresence");
     add(this, &Session::execute, "Execute");
@@ -788,7 +796,16 @@ void Session::doneCb(bool success, const SyncReport &report) throw()
             m_error = STATUS_FATAL + sysync::LOCAL_STATUS_CODE;
         }
 
+        if (m_progressThrottle.getUnflushed()) {
+            fireProgress(true);
+        }
         fireStatus(true);
+        SE_LOG_DEBUG(NULL, "session %s: sent %ld status and %ld progress signals, suppressed %ld resp. %ld",
+                     getPath(),
+                     (long)m_statusThrottle.getEmitted(),
+                     (long)m_progressThrottle.getEmitted(),
+                     (long)m_statusThrottle.getSuppressed(),
+                     (long)m_progressThrottle.getSuppressed());
 
         boost::shared_ptr<Connection> connection = m_connection.lock();
         if (connection) {
@@ -872,21 +889,34 @@ void Session::useHelperAsync(const SimpleResult &result, const StringMap &env)
         // might happen is when the helper is still starting when
         // a new request comes in. In that case we reuse the same
         // helper process for both operations.
+        GDBusCXX::DBusConnectionPtr pooledConn;
         if (!m_forkExecParent ||
             m_forkExecParent->getState() != ForkExecParent::STARTING) {
-            std::vector<std::string> args;
-            args.push_back("--dbus-verbosity");
-            args.push_back(StringPrintf("%d", m_server.getDBusLogLevel()));
-            m_forkExecParent = SyncEvo::ForkExecParent::create("syncevo-dbus-helper", args);
-#ifdef USE_DLT
-            if (getenv("SYNCEVOLUTION_USE_DLT")) {
-                m_forkExecParent->addEnvVar("SYNCEVOLUTION_USE_DLT", StringPrintf("%d", LoggerDLT::getCurrentDLTLogLevel()));
+            // Pooled helpers were started without additional env
+            // variables, so they can only be used when none are
+            // needed.
+            boost::shared_ptr<HelperPool::Helper> pooled;
+            if (env.empty() && m_server.getHelperPool()) {
+                pooled = m_server.getHelperPool()->claim(m_server.getDBusLogLevel());
             }
+            if (pooled) {
+                m_forkExecParent = pooled->m_forkExecParent;
+                pooledConn = pooled->m_conn;
+            } else {
+                std::vector<std::string> args;
+                args.push_back("--dbus-verbosity");
+                args.push_back(StringPrintf("%d", m_server.getDBusLogLevel()));
+                m_forkExecParent = SyncEvo::ForkExecParent::create("syncevo-dbus-helper", args);
+#ifdef USE_DLT
+                if (getenv("SYNCEVOLUTION_USE_DLT")) {
+                    m_forkExecParent->addEnvVar("SYNCEVOLUTION_USE_DLT", StringPrintf("%d", LoggerDLT::getCurrentDLTLogLevel()));
+                }
 #endif
-            BOOST_FOREACH (const StringPair &entry, env) {
-                SE_LOG_DEBUG(NULL, "running helper with env variable %s=%s",
-                             entry.first.c_str(), entry.second.c_str());
-                m_forkExecParent->addEnvVar(entry.first, entry.second);
+                BOOST_FOREACH (const StringPair &entry, env) {
+                    SE_LOG_DEBUG(NULL, "running helper with env variable %s=%s",
+                                 entry.first.c_str(), entry.second.c_str());
+                    m_forkExecParent->addEnvVar(entry.first, entry.second);
+                }
             }
             // We own m_forkExecParent, so the "this" pointer for
             // onConnect will live longer than the signal in
@@ -918,10 +948,17 @@ void Session::useHelperAsync(const SimpleResult &result, const StringMap &env)
         boost::signals2::connection c = m_forkExecParent->m_onQuit.connect(boost::bind(&raiseChildTermError,
                                                                                        _1,
                                                                                        result));
-        m_forkExecParent->m_onConnect.connect(boost::bind(&Session::useHelper2,
-                                                          this,
-                                                          result,
-                                                          c));
+        if (pooledConn) {
+            // Pooled helper has already connected, m_onConnect won't
+            // be triggered again.
+            onConnect(pooledConn);
+            useHelper2(result, c);
+        } else {
+            m_forkExecParent->m_onConnect.connect(boost::bind(&Session::useHelper2,
+                                                              this,
+                                                              result,
+                                                              c));
+        }
 
         if (m_forkExecParent->getState() == ForkExecParent::IDLE) {
             m_forkExecParent->start();
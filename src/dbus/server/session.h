@@ -34,7 +34,7 @@
 #include "progress-data.h"
 #include "source-progress.h"
 #include "source-status.h"
-#include "timer.h"
+#include "signal-throttle.h"
 #include "resource.h"
 #include "dbus-callbacks.h"
 
@@ -234,9 +234,13 @@ class Session : public GDBusCXX::DBusObjectHelper,
                         SyncMode sourceSyncMode,
                         int32_t extra1, int32_t extra2, int32_t extra3);
 
-    /** timer for fire status/progress usages */
-    Timer m_statusTimer;
-    Timer m_progressTimer;
+    /**
+     * Rate limiting for status/progress signals. Changes which
+     * arrive too quickly get coalesced and are sent at the end of
+     * the interval.
+     */
+    SignalThrottle m_statusThrottle;
+    SignalThrottle m_progressThrottle;
 
     /** the total number of sources to be restored */
     int m_restoreSrcTotal;
@@ -294,6 +298,8 @@ class Session : public GDBusCXX::DBusObjectHelper,
     /** Session.GetProgress() */
     void getAPIProgress(int32_t &progress,
                         APISourceProgresses_t &sources);
+    /** Session.GetSuppressedSignals() */
+    std::map<std::string, uint32_t> getSuppressedSignals();
     /** Internal, with more information. */
     void getProgress(int32_t &progress,
                      SourceProgresses_t &sources);
@@ -354,7 +360,7 @@ public:
      * frequently (say, every second). In practice it gets updated at
      * the end of processing each SyncML message.
      */
-    void setProgressTimeout(unsigned long ms) { m_progressTimer.setTimeout(ms); }
+    void setProgressTimeout(unsigned long ms) { m_progressThrottle.setInterval(ms); }
 
     /**
      * Sessions must always be held in a shared pointer
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2013 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ */
+
+#ifndef SIGNAL_THROTTLE_H
+#define SIGNAL_THROTTLE_H
+
+#include "timer.h"
+
+#include <syncevo/SmartPtr.h>
+#include <syncevo/util.h>
+#include <syncevo/ThreadSupport.h>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+#include <glib.h>
+
+#include <syncevo/declarations.h>
+SE_BEGIN_CXX
+
+/**
+ * Limits how often a D-Bus signal gets emitted. At most "burst"
+ * signals are allowed per interval. Signals beyond that get
+ * suppressed and counted. If a flush callback is set, it gets
+ * invoked once at the end of an interval in which signals were
+ * suppressed, so that the final state always reaches the clients
+ * even if no further event triggers a signal.
+ *
+ * Typical usage:
+ *
+ * void fireFoo(bool flush)
+ * {
+ *     if (!m_fooThrottle.check(flush)) {
+ *         return;
+ *     }
+ *     m_fooSignal(...);
+ * }
+ *
+ * with fireFoo(true) as flush callback.
+ *
+ * The class itself is not thread-safe. The flush callback is invoked
+ * by the main loop. Owners which call check() in other threads must
+ * serialize those calls with a mutex and pass that mutex to
+ * setMutex(), then the main loop locks it before touching the
+ * throttle. The flush callback gets called without holding the mutex.
+ */
+class SignalThrottle : private boost::noncopyable
+{
+    Timer m_timer;              ///< start of current interval
+    unsigned long m_intervalMs; ///< length of an interval, 0 for no throttling
+    unsigned m_burst;           ///< number of signals allowed per interval
+    unsigned m_sent;            ///< signals sent in current interval
+    boost::function<void ()> m_flush;
+    GLibEvent m_pending;        ///< active while a flush is scheduled
+    DynMutex *m_mutex;          ///< protects the throttle, may be NULL
+
+    size_t m_emitted;           ///< total number of signals allowed
+    size_t m_suppressed;        ///< total number of signals suppressed
+    size_t m_unflushed;         ///< signals suppressed since last emitted signal
+
+    static gboolean triggered(gpointer data) throw ()
+    {
+        SignalThrottle *me = static_cast<SignalThrottle *>(data);
+        try {
+            DynMutex::Guard guard;
+            if (me->m_mutex) {
+                guard = me->m_mutex->lock();
+            }
+            // Returning false removes the source. While waiting for
+            // the lock, check() might have replaced it with a new
+            // timeout, which must stay active.
+            if (me->m_pending.get() == g_source_get_id(g_main_current_source())) {
+                me->m_pending.release();
+            }
+            bool flush = me->m_flush && me->m_unflushed;
+            guard.unlock();
+            // Must check again under the owner's lock.
+            if (flush) {
+                me->m_flush();
+            }
+        } catch (...) {
+            Exception::handle(HANDLE_EXCEPTION_NO_ERROR);
+        }
+        return false;
+    }
+
+ public:
+    /**
+     * @param intervalMs   length of an interval in milliseconds, 0 disables throttling
+     * @param flush        called with pending changes at the end of an interval, may be empty
+     * @param burst        number of signals allowed per interval
+     */
+    SignalThrottle(unsigned long intervalMs,
+                   const boost::function<void ()> &flush = boost::function<void ()>(),
+                   unsigned burst = 1) :
+        m_timer(intervalMs),
+        m_intervalMs(intervalMs),
+        m_burst(burst),
+        m_sent(0),
+        m_flush(flush),
+        m_mutex(NULL),
+        m_emitted(0),
+        m_suppressed(0),
+        m_unflushed(0)
+    {
+    }
+
+    void setInterval(unsigned long intervalMs) { m_intervalMs = intervalMs; m_timer.setTimeout(intervalMs); }
+    void setBurst(unsigned burst) { m_burst = burst; }
+    void setMutex(DynMutex *mutex) { m_mutex = mutex; }
+
+    /**
+     * Decide whether the caller may emit its signal now.
+     *
+     * @param flush    always allow the signal (final state, important change)
+     * @return true if the signal must be sent, false if it was suppressed
+     */
+    bool check(bool flush = false)
+    {
+        if (!m_intervalMs || m_timer.timeout()) {
+            m_timer.reset();
+            m_sent = 0;
+        }
+        if (flush || !m_intervalMs || m_sent < m_burst) {
+            m_sent++;
+            m_emitted++;
+            m_unflushed = 0;
+            m_pending.reset();
+            return true;
+        }
+
+        m_suppressed++;
+        m_unflushed++;
+        if (m_flush && !m_pending) {
+            unsigned long elapsed = m_timer.elapsed();
+            m_pending.set(g_timeout_add(elapsed < m_intervalMs ? m_intervalMs - elapsed : 0,
+                                        triggered,
+                                        static_cast<gpointer>(this)),
+                          "signal throttle timeout");
+        }
+        return false;
+    }
+
+    /** number of signals suppressed since the last one which was emitted */
+    size_t getUnflushed() const { return m_unflushed; }
+
+    /** total number of emitted signals */
+    size_t getEmitted() const { return m_emitted; }
+
+    /** total number of suppressed signals */
+    size_t getSuppressed() const { return m_suppressed; }
+};
+
+SE_END_CXX
+
+#endif // SIGNAL_THROTTLE_H
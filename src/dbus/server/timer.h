@@ -70,7 +70,15 @@ class Timer {
      */
     bool timeout(unsigned long timeoutMs)
     {
-        return (Timespec::monotonic() - m_startTime).duration() * 1000 >= timeoutMs;
+        return elapsed() >= timeoutMs;
+    }
+
+    /**
+     * milliseconds since start time
+     */
+    unsigned long elapsed()
+    {
+        return (Timespec::monotonic() - m_startTime).duration() * 1000;
     }
 };
 
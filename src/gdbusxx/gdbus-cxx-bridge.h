@@ -1975,6 +1975,88 @@ template<class V> struct dbus_traits< DBusArray<V> > : public dbus_traits_base
     }
 };
 
+/**
+ * Same as DBusArray, but the memory stays valid as long as some copy
+ * of the instance exists. The owner is some arbitrary object which
+ * keeps the memory alive.
+ *
+ * When receiving, the owner is the GVariant which contains the data,
+ * so the data gets referenced instead of copied. When sending, the
+ * message holds a reference to the owner until it no longer needs
+ * the data, therefore this type can also be used for return values.
+ */
+template<class V> class DBusSharedArray : public DBusArray<V>
+{
+    boost::shared_ptr<const void> m_owner;
+
+ public:
+    DBusSharedArray() {}
+    DBusSharedArray(size_t len, const V *data, const boost::shared_ptr<const void> &owner) :
+        DBusArray<V>(len, data),
+        m_owner(owner)
+        {}
+
+    const boost::shared_ptr<const void> &getOwner() const { return m_owner; }
+};
+
+/** deleter for a GVariant in a boost::shared_ptr<const void> */
+struct GVariantUnref
+{
+    void operator () (const void *var) const { g_variant_unref(static_cast<GVariant *>(const_cast<void *>(var))); }
+};
+
+template<class V> struct dbus_traits< DBusSharedArray<V> > : public dbus_traits< DBusArray<V> >
+{
+    typedef DBusSharedArray<V> host_type;
+    typedef const host_type &arg_type;
+
+    static void get(ExtractArgs &context,
+                    GVariantIter &iter, host_type &array)
+    {
+        GVariant *var = g_variant_iter_next_value(&iter);
+        if (var == NULL) {
+            throw std::runtime_error("g_variant failure " GDBUS_CXX_SOURCE_INFO);
+        }
+        // owns the reference from now on
+        boost::shared_ptr<const void> owner(var, GVariantUnref());
+        if (!g_variant_type_is_subtype_of(g_variant_get_type(var), G_VARIANT_TYPE_ARRAY)) {
+            throw std::runtime_error("g_variant failure " GDBUS_CXX_SOURCE_INFO);
+        }
+        typedef typename dbus_traits<V>::host_type V_host_type;
+        gsize nelements;
+        const V_host_type *data;
+        data = static_cast<const V_host_type *>(g_variant_get_fixed_array(var,
+                                                                          &nelements,
+                                                                          static_cast<gsize>(sizeof(V_host_type))));
+        array = host_type(nelements, data, owner);
+    }
+
+    static void releaseOwner(gpointer owner)
+    {
+        delete static_cast< boost::shared_ptr<const void> * >(owner);
+    }
+
+    static void append(GVariantBuilder &builder, arg_type array)
+    {
+        typedef typename dbus_traits<V>::host_type V_host_type;
+        const std::string type = dbus_traits< DBusArray<V> >::getType();
+        g_variant_builder_add_value(&builder,
+                                    array.getOwner() ?
+                                    g_variant_new_from_data(G_VARIANT_TYPE(type.c_str()),
+                                                            (gconstpointer)array.second,
+                                                            array.first * sizeof(V_host_type),
+                                                            true, // data is trusted to be in serialized form
+                                                            releaseOwner,
+                                                            new boost::shared_ptr<const void>(array.getOwner())) :
+                                    g_variant_new_from_data(G_VARIANT_TYPE(type.c_str()),
+                                                            (gconstpointer)array.second,
+                                                            array.first * sizeof(V_host_type),
+                                                            true,
+                                                            NULL, NULL // caller guarantees that data remains valid
+                                                            ));
+    }
+};
+
 /**
  * a std::map - treat it like a D-Bus dict
  */
@@ -42,6 +42,7 @@
 #include <set>
 #include <list>
 #include <algorithm>
+#include <limits>
 using namespace std;
 
 #include <boost/shared_ptr.hpp>
@@ -1449,6 +1450,13 @@ bool Cmdline::run() {
                 sysync::ItemIDType id;
                 id.item = (char *)luid.c_str();
                 err = ops.m_deleteItem(&id);
+                while (err == sysync::LOCERR_AGAIN) {
+                    // Flush and wait, because the command line is
+                    // not prepared to deal with asynchronous execution.
+                    source->flushItemChanges();
+                    source->finishItemChanges();
+                    err = ops.m_deleteItem(&id);
+                }
                 CHECK_ERROR("deleting item");
             }
             char *token;
@@ -1677,20 +1685,19 @@ bool Cmdline::run() {
             context->status();
         } else if (m_printSessions) {
             vector<string> dirs;
-            context->getSessions(dirs);
-            bool first = true;
-            BOOST_FOREACH(const string &dir, dirs) {
-                if (first) {
-                    first = false;
-                } else if(!m_quiet) {
+            vector<string> peers;
+            vector<SyncReport> reports;
+            context->readSessionInfos(0, std::numeric_limits<size_t>::max(),
+                                      dirs, peers, reports);
+            // oldest session first
+            for (size_t i = dirs.size(); i > 0; i--) {
+                if (i < dirs.size() && !m_quiet) {
                     SE_LOG_SHOW(NULL, "\n");
                 }
-                SE_LOG_SHOW(NULL, "%s", dir.c_str());
+                SE_LOG_SHOW(NULL, "%s", dirs[i - 1].c_str());
                 if (!m_quiet) {
-                    SyncReport report;
-                    context->readSessionInfo(dir, report);
                     ostringstream out;
-                    out << report;
+                    out << reports[i - 1];
                     SE_LOG_SHOW(NULL, "%s", out.str().c_str());
                 }
             }
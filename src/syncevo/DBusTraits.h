@@ -130,6 +130,109 @@ namespace GDBusCXX {
                                   GDBusCXX::dbus_member<SyncEvo::UserIdentity, SyncEvo::InitStateString, &SyncEvo::UserIdentity::m_provider,
                                   GDBusCXX::dbus_member_single<SyncEvo::UserIdentity, SyncEvo::InitStateString, &SyncEvo::UserIdentity::m_identity> > >
     {};
+
+    /**
+     * Sent as byte array containing SyncReport::toBinary(), which
+     * can be decoded without parsing text. Only used between
+     * SyncEvolution processes, never by clients.
+     */
+#ifdef GDBUS_CXX_GIO
+    template <> struct dbus_traits<SyncEvo::SyncReport> :
+        public dbus_traits< DBusSharedArray<uint8_t> >
+    {
+        typedef dbus_traits< DBusSharedArray<uint8_t> > base;
+
+        typedef SyncEvo::SyncReport host_type;
+        typedef const SyncEvo::SyncReport &arg_type;
+
+        static void get(ExtractArgs &context,
+                        reader_type &iter, host_type &report)
+        {
+            base::host_type array;
+            base::get(context, iter, array);
+            report.fromBinary(reinterpret_cast<const char *>(array.second), array.first);
+        }
+
+        static void append(builder_type &builder, arg_type report)
+        {
+            // the message keeps the buffer alive while it needs it
+            boost::shared_ptr<std::string> buffer(new std::string(report.toBinary()));
+            base::append(builder, base::host_type(buffer->size(),
+                                                  reinterpret_cast<const uint8_t *>(buffer->c_str()),
+                                                  buffer));
+        }
+    };
+#else
+    template <> struct dbus_traits<SyncEvo::SyncReport> :
+        public dbus_traits< DBusArray<uint8_t> >
+    {
+        typedef dbus_traits< DBusArray<uint8_t> > base;
+
+        typedef SyncEvo::SyncReport host_type;
+        typedef const SyncEvo::SyncReport &arg_type;
+
+        static void get(connection_type *conn, message_type *msg,
+                        reader_type &iter, host_type &report)
+        {
+            base::host_type array;
+            base::get(conn, msg, iter, array);
+            report.fromBinary(reinterpret_cast<const char *>(array.second), array.first);
+        }
+
+        static void append(builder_type &builder, arg_type report)
+        {
+            std::string buffer = report.toBinary();
+            base::append(builder, base::host_type(buffer.size(), reinterpret_cast<const uint8_t *>(buffer.c_str())));
+        }
+    };
+#endif
+
+    /**
+     * Sent as SyncReport with a single entry "foo".
+     */
+    template <> struct dbus_traits<SyncEvo::SyncSourceReport> :
+        public dbus_traits<SyncEvo::SyncReport>
+    {
+        typedef dbus_traits<SyncEvo::SyncReport> base;
+
+        typedef SyncEvo::SyncSourceReport host_type;
+        typedef const SyncEvo::SyncSourceReport &arg_type;
+
+#ifdef GDBUS_CXX_GIO
+        static void get(ExtractArgs &context,
+                        reader_type &iter, host_type &source)
+        {
+            SyncEvo::SyncReport report;
+            base::get(context, iter, report);
+            source = getSource(report);
+        }
+#else
+        static void get(connection_type *conn, message_type *msg,
+                        reader_type &iter, host_type &source)
+        {
+            SyncEvo::SyncReport report;
+            base::get(conn, msg, iter, report);
+            source = getSource(report);
+        }
+#endif
+
+        static void append(builder_type &builder, arg_type source)
+        {
+            SyncEvo::SyncReport report;
+            report.addSyncSourceReport("foo", source);
+            base::append(builder, report);
+        }
+
+    private:
+        static const SyncEvo::SyncSourceReport &getSource(const SyncEvo::SyncReport &report)
+        {
+            const SyncEvo::SyncSourceReport *foo = report.findSyncSourceReport("foo");
+            if (!foo) {
+                SE_THROW_EXCEPTION(SyncEvo::Exception, "incomplete SyncReport");
+            }
+            return *foo;
+        }
+    };
 }
 
 #endif // INCL_SYNCEVO_DBUS_TRAITS
@@ -190,12 +190,16 @@ static void changed(GFileMonitor *monitor,
 }
 
 GLibNotify::GLibNotify(const char *file, 
-                       const callback_t &callback) :
+                       const callback_t &callback,
+                       bool directory) :
     m_callback(callback)
 {
     GFileCXX filecxx(g_file_new_for_path(file), TRANSFER_REF);
     GErrorCXX gerror;
-    GFileMonitorCXX monitor(g_file_monitor_file(filecxx.get(), G_FILE_MONITOR_NONE, NULL, gerror), TRANSFER_REF);
+    GFileMonitorCXX monitor(directory ?
+                            g_file_monitor_directory(filecxx.get(), G_FILE_MONITOR_NONE, NULL, gerror) :
+                            g_file_monitor_file(filecxx.get(), G_FILE_MONITOR_NONE, NULL, gerror),
+                            TRANSFER_REF);
     m_monitor.swap(monitor);
     if (!m_monitor) {
         gerror.throwError(SE_HERE, std::string("monitoring ") + file);
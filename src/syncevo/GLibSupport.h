@@ -323,7 +323,7 @@ SE_GLIB_TYPE(GIOChannel, g_io_channel)
 SE_BEGIN_CXX
 
 /**
- * Wrapper around g_file_monitor_file().
+ * Wrapper around g_file_monitor_file() and g_file_monitor_directory().
  * Not copyable because monitor is tied to specific callback
  * via memory address.
  */
@@ -332,8 +332,12 @@ class GLibNotify : public boost::noncopyable
  public:
     typedef boost::function<void (GFile *, GFile *, GFileMonitorEvent)> callback_t;
 
+    /**
+     * @param directory    watch entries in the directory instead of the file itself
+     */
     GLibNotify(const char *file, 
-               const callback_t &callback);
+               const callback_t &callback,
+               bool directory = false);
  private:
     GFileMonitorCXX m_monitor;
     callback_t m_callback;
@@ -179,7 +179,9 @@ LocalTransportAgent::LocalTransportAgent(SyncContext *server,
     m_status(INACTIVE),
     m_loop(loop ?
            GMainLoopCXX(static_cast<GMainLoop *>(loop), ADD_REF) :
-           GMainLoopCXX(g_main_loop_new(NULL, false), TRANSFER_REF))
+           GMainLoopCXX(g_main_loop_new(NULL, false), TRANSFER_REF)),
+    m_syncRequested(false),
+    m_syncStarted(false)
 {
     SMLTKSharedMemory::singleton().initParent(server->getMaxMsgSize());
 }
@@ -320,6 +322,15 @@ void LocalTransportAgent::onChildConnect(const GDBusCXX::DBusConnectionPtr &conn
     m_parent->activate();
     m_child.reset(new LocalTransportChild(conn));
     m_child->m_logOutput.activate(boost::bind(&LocalTransportAgent::logChildOutput, this, _1, _2, _3));
+    startChildSync();
+}
+
+void LocalTransportAgent::startChildSync()
+{
+    if (!m_child || !m_syncRequested || m_syncStarted) {
+        return;
+    }
+    m_syncStarted = true;
 
     // now tell child what to do
     LocalTransportChild::ActiveSources_t sources;
@@ -424,11 +435,11 @@ void LocalTransportAgent::askPassword(const std::string &passwordName,
     }
 }
 
-void LocalTransportAgent::storeSyncReport(const std::string &report)
+void LocalTransportAgent::storeSyncReport(const SyncReport &report)
 {
-    SE_LOG_DEBUG(NULL, "got child sync report:\n%s",
-                 report.c_str());
-    m_clientReport = SyncReport(report);
+    // Content was logged by the child.
+    SE_LOG_DEBUG(NULL, "got child sync report");
+    m_clientReport = report;
 }
 
 void LocalTransportAgent::getClientSyncReport(SyncReport &report)
@@ -528,6 +539,11 @@ TransportAgent::Status LocalTransportAgent::wait(bool noReply)
         if (noReply) {
             m_status = INACTIVE;
         } else {
+            // The child might have been started and connected while
+            // the parent was still preparing the sync. Tell it to sync
+            // now, or as soon as it has connected.
+            m_syncRequested = true;
+            startChildSync();
             while (m_status == ACTIVE) {
                 SE_LOG_DEBUG(NULL, "waiting for child to send message");
                 if (m_forkexec &&
@@ -1121,9 +1137,8 @@ public:
                 m_clientReport.setError(explanation);
             }
             if (m_parent) {
-                std::string report = m_clientReport.toString();
-                SE_LOG_DEBUG(NULL, "child sending sync report after failure:\n%s", report.c_str());
-                m_parent->m_storeSyncReport.start(report,
+                SE_LOG_DEBUG(NULL, "child sending sync report after failure:\n%s", m_clientReport.toString().c_str());
+                m_parent->m_storeSyncReport.start(m_clientReport,
                                                   boost::bind(&LocalTransportAgentChild::syncReportReceived, this, _1));
                 // wait for acknowledgement for report once:
                 // we are in some kind of error state, better
@@ -1138,9 +1153,8 @@ public:
 
         if (m_parent) {
             // send final report, ignore result
-            std::string report = m_clientReport.toString();
-            SE_LOG_DEBUG(NULL, "child sending sync report:\n%s", report.c_str());
-            m_parent->m_storeSyncReport.start(report,
+            SE_LOG_DEBUG(NULL, "child sending sync report:\n%s", m_clientReport.toString().c_str());
+            m_parent->m_storeSyncReport.start(m_clientReport,
                                               boost::bind(&LocalTransportAgentChild::syncReportReceived, this, _1));
             while (!m_reportSent && m_parent &&
                    s.getState() == SuspendFlags::NORMAL) {
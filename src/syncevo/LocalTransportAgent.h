@@ -85,6 +85,11 @@ class LocalTransportAgent : public TransportAgent
 
     /**
      * Set up message passing and fork the client.
+     *
+     * The child starts up and connects in the background. It only
+     * gets asked to sync once the parent waits for its first
+     * message, so start() may be called early while the parent is
+     * still preparing its side of the sync.
      */
     void start();
 
@@ -134,6 +139,14 @@ class LocalTransportAgent : public TransportAgent
      */
     boost::shared_ptr<LocalTransportChild> m_child;
 
+    /** set by wait() when the parent is ready for the child's first message */
+    bool m_syncRequested;
+    /** set once the StartSync call was sent to the child */
+    bool m_syncStarted;
+
+    /** sends StartSync if the child is connected and the parent is ready */
+    void startChildSync();
+
     void logChildOutput(const std::string &level, const std::string &prefix, const std::string &message);
     void onChildConnect(const GDBusCXX::DBusConnectionPtr &conn);
     void onFailure(const std::string &error);
@@ -142,7 +155,7 @@ class LocalTransportAgent : public TransportAgent
                      const std::string &descr,
                      const ConfigPasswordKey &key,
                      const boost::shared_ptr< GDBusCXX::Result1<const std::string &> > &reply);
-    void storeSyncReport(const std::string &report);
+    void storeSyncReport(const SyncReport &report);
     void storeReplyMsg(const std::string &contentType,
                        size_t offset, size_t len,
                        const std::string &error);
@@ -1792,9 +1792,12 @@ static SecondsConfigProperty syncPropAutoSyncInterval("autoSyncInterval",
                                                       "side. Some SyncML server operators only allow a\n"
                                                       "certain number of sessions per day.\n"
                                                       "The value 0 has the effect of only running automatic\n"
-                                                      "synchronization when changes are detected (not\n"
-                                                      "implemented yet, therefore it basically disables\n"
-                                                      "automatic synchronization).\n",
+                                                      "synchronization when local changes are detected.\n"
+                                                      "That is possible for the file backend and databases\n"
+                                                      "in Evolution Data Server, otherwise it disables\n"
+                                                      "automatic synchronization. Independently of this\n"
+                                                      "interval, local changes in such databases trigger an\n"
+                                                      "automatic synchronization shortly after the last change.\n",
                                                       "30M");
 
 static SecondsConfigProperty syncPropAutoSyncDelay("autoSyncDelay",
@@ -2116,6 +2119,65 @@ void PasswordConfigProperty::checkPasswords(UserInterface &ui,
     }
 }
 
+/**
+ * Turns password requests from PasswordConfigProperty::checkPassword()
+ * into PasswordCache::prefetch() calls.
+ */
+class PrefetchUserInterface : public UserInterface
+{
+    PasswordCache &m_cache;
+    const InitStateTri &m_keyring;
+
+public:
+    PrefetchUserInterface(PasswordCache &cache, const InitStateTri &keyring) :
+        m_cache(cache),
+        m_keyring(keyring)
+    {}
+
+    virtual std::string askPassword(const std::string &passwordName,
+                                    const std::string &descr,
+                                    const ConfigPasswordKey &key)
+    {
+        m_cache.prefetch(m_keyring, passwordName, descr, key);
+        return "";
+    }
+    virtual bool savePassword(const std::string &passwordName, const std::string &password, const ConfigPasswordKey &key) { return false; }
+    virtual void readStdin(std::string &content) { content.clear(); }
+};
+
+void PasswordConfigProperty::prefetchPasswords(PasswordCache &cache,
+                                               const InitStateTri &keyring,
+                                               SyncConfig &config,
+                                               int flags,
+                                               const std::list<std::string> &sourceNames)
+{
+    PrefetchUserInterface ui(cache, keyring);
+    // Only look, don't modify the config.
+    flags &= ~(CHECK_PASSWORD_RESOLVE_USERNAME|CHECK_PASSWORD_RESOLVE_PASSWORD);
+    if (flags & CHECK_PASSWORD_SYNC) {
+        ConfigPropertyRegistry& registry = SyncConfig::getRegistry();
+        BOOST_FOREACH(const ConfigProperty *prop, registry) {
+            try {
+                prop->checkPassword(ui, config, flags);
+            } catch (...) {
+                Exception::log();
+            }
+        }
+    }
+    if (flags & CHECK_PASSWORD_SOURCE) {
+        BOOST_FOREACH (const std::string &sourceName, sourceNames) {
+            ConfigPropertyRegistry &registry = SyncSourceConfig::getRegistry();
+            BOOST_FOREACH(const ConfigProperty *prop, registry) {
+                try {
+                    prop->checkPassword(ui, config, flags, sourceName);
+                } catch (...) {
+                    Exception::log();
+                }
+            }
+        }
+    }
+}
+
 std::string PasswordConfigProperty::getUsername(const ConfigProperty &usernameProperty,
                                                 const FilterConfigNode &node)
 {
@@ -128,6 +128,7 @@ class SyncSourceConfig;
 typedef SyncSourceConfig PersistentSyncSourceConfig;
 class ConfigTree;
 class UserInterface;
+class PasswordCache;
 class SyncSourceNodes;
 class ConstSyncSourceNodes;
 class SyncConfig;
@@ -762,6 +763,19 @@ class PasswordConfigProperty : public ConfigProperty {
                                int flags,
                                const std::list<std::string> &sourceNames = std::list<std::string>());
 
+    /**
+     * Starts looking up all passwords which checkPasswords() with the
+     * same parameters would retrieve from the keyring, without waiting
+     * for the results. The lookups run in parallel if the keyring
+     * supports that. Errors are ignored here, they are reported
+     * by PasswordCache::load().
+     */
+    static void prefetchPasswords(PasswordCache &cache,
+                                  const InitStateTri &keyring,
+                                  SyncConfig &config,
+                                  int flags,
+                                  const std::list<std::string> &sourceNames = std::list<std::string>());
+
     enum {
         CHECK_PASSWORD_RESOLVE_USERNAME = 1<<0,   ///< temporarily replace username that corresponds to the password
         CHECK_PASSWORD_RESOLVE_PASSWORD = 1<<1,   ///< temporarily replace password with actual value
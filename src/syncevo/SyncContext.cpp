@@ -32,6 +32,7 @@
 
 #include <syncevo/SafeConfigNode.h>
 #include <syncevo/IniConfigNode.h>
+#include <syncevo/PrefixConfigNode.h>
 
 #include <syncevo/LogStdout.h>
 #include <syncevo/TransportAgent.h>
@@ -170,6 +171,8 @@ class LogDirNames {
 public:
     // internal prefix for backup directory name: "SyncEvolution-"
     static const char* const DIR_PREFIX;
+    // name of the session index inside the log dir, see LogDir::getIndex()
+    static const char* const INDEX_FILE;
 
     /**
      * Compare two directory by its creation time encoded
@@ -337,12 +340,20 @@ class LogDir : private boost::noncopyable, private LogDirNames {
     // thread and any thread which might log errors.
     friend class LogDirLogger;
     bool m_readonly;         /**< m_info is not to be written to */
+    bool m_indexed;          /**< add current session to index in endSession() */
     SyncReport *m_report;    /**< record start/end times here */
 
+    /**
+     * Content of the session index, loaded on demand. Maps the
+     * directory name of a session to the content of its status.ini.
+     */
+    typedef std::map<string, ConfigProps> Index_t;
+    boost::scoped_ptr<Index_t> m_index;
+
     boost::weak_ptr<LogDir> m_self;
     PushLogger<LogDirLogger> m_logger; /**< active logger */
 
-    LogDir(SyncContext &client) : m_client(client), m_info(NULL), m_readonly(false), m_report(NULL)
+    LogDir(SyncContext &client) : m_client(client), m_info(NULL), m_readonly(false), m_indexed(false), m_report(NULL)
     {
         // Set default log directory. This will be overwritten with a user-specified
         // location later on, if one was selected by the user. SyncEvolution >= 0.9 alpha
@@ -478,6 +489,18 @@ public:
         *m_info >> report;
     }
 
+    /**
+     * read sync report for an arbitrary session, using the session
+     * index if possible and status.ini of the session otherwise
+     */
+    void readSessionReport(const string &dir, SyncReport &report) {
+        if (!readIndexedReport(dir, report)) {
+            LogDir logdir(m_client);
+            logdir.openLogdir(dir);
+            logdir.readReport(report);
+        }
+    }
+
     /**
      * write sync report for current session
      */
@@ -570,6 +593,7 @@ public:
                 m_path += m_prefix;
                 m_path += path.str();
                 mkdir_p(m_path);
+                m_indexed = true;
             } else {
                 m_path = m_logdir;
                 if (mkdir(m_path.c_str(), S_IRWXU) &&
@@ -686,10 +710,8 @@ public:
                 bool havedumps = false;
                 bool errors = false;
 
-                LogDir logdir(m_client);
-                logdir.openLogdir(dirs[i]);
                 SyncReport report;
-                logdir.readReport(report);
+                readSessionReport(dirs[i], report);
                 SyncMLStatus status = report.getStatus();
                 if (status != STATUS_OK && status != STATUS_HTTP_OK) {
                     errors = true;
@@ -768,6 +790,9 @@ public:
                     }
                 }
             }
+            if (deleted) {
+                updateIndex(NULL);
+            }
         }
     }
 
@@ -786,6 +811,15 @@ public:
                     writeReport(*m_report);
                 }
                 m_info->flush();
+                if (m_indexed && m_report) {
+                    try {
+                        updateIndex(m_report);
+                    } catch (...) {
+                        // The index is only a cache, status.ini is
+                        // still valid.
+                        Exception::handle(HANDLE_EXCEPTION_NO_ERROR);
+                    }
+                }
             }
             m_info.reset();
         }
@@ -941,6 +975,87 @@ private:
         }
     }
 
+    /**
+     * The session index is a single .ini file in the log dir with
+     * the status.ini content of all sessions which ended normally,
+     * using "<session dir name>/<status.ini key>" as key. It avoids
+     * opening the status.ini file of each session when listing
+     * sessions. Sessions without entry (still running, crashed,
+     * written by older SyncEvolution) fall back to status.ini, so
+     * the index never has to be complete.
+     */
+    const Index_t &getIndex() {
+        if (!m_index) {
+            m_index.reset(new Index_t);
+            if (!m_logdir.empty() && m_logdir != "none") {
+                IniHashConfigNode node(m_logdir, INDEX_FILE, true);
+                ConfigProps props;
+                node.readProperties(props);
+                BOOST_FOREACH(const ConfigProps::value_type &entry, props) {
+                    size_t off = entry.first.find('/');
+                    if (off != entry.first.npos) {
+                        (*m_index)[entry.first.substr(0, off)][entry.first.substr(off + 1)] = entry.second;
+                    }
+                }
+            }
+        }
+        return *m_index;
+    }
+
+    /**
+     * read sync report for session from the index
+     * @return false if not found there
+     */
+    bool readIndexedReport(const string &dir, SyncReport &report) {
+        string dirPath, dirName;
+        parseLogDir(dir, dirPath, dirName);
+        if (dirPath != m_logdir) {
+            return false;
+        }
+        const Index_t &index = getIndex();
+        Index_t::const_iterator it = index.find(dirName);
+        if (it == index.end()) {
+            return false;
+        }
+        boost::shared_ptr<ConfigNode> node(new IniHashConfigNode("/dev/null", "", true));
+        node->writeProperties(it->second);
+        SafeConfigNode info(node);
+        info.setMode(false);
+        report.clear();
+        info >> report;
+        return true;
+    }
+
+    /**
+     * add report of current session to the index (if not NULL) and
+     * remove entries of sessions which no longer exist
+     */
+    void updateIndex(const SyncReport *report) {
+        boost::shared_ptr<ConfigNode> node(new IniHashConfigNode(m_logdir, INDEX_FILE, false));
+        ConfigProps props;
+        node->readProperties(props);
+        map<string, bool> exists;
+        BOOST_FOREACH(const ConfigProps::value_type &entry, props) {
+            string name = entry.first.substr(0, entry.first.find('/'));
+            map<string, bool>::iterator it = exists.find(name);
+            if (it == exists.end()) {
+                it = exists.insert(make_pair(name, isDir(m_logdir + "/" + name))).first;
+            }
+            if (!it->second) {
+                node->removeProperty(entry.first);
+            }
+        }
+        if (report) {
+            string dirPath, dirName;
+            parseLogDir(m_path, dirPath, dirName);
+            SafeConfigNode info(boost::shared_ptr<ConfigNode>(new PrefixConfigNode(dirName + "/", node)));
+            info.setMode(false);
+            info << *report;
+        }
+        node->flush();
+        m_index.reset();
+    }
+
     // store time stamp in session info
     void writeTimestamp(const string &key, time_t val, bool flush = true) {
         if (m_info) {
@@ -1055,6 +1170,7 @@ void LogDirLogger::messagev(const MessageOptions &options,
 
 
 const char* const LogDirNames::DIR_PREFIX = "SyncEvolution-";
+const char* const LogDirNames::INDEX_FILE = "session-index.ini";
 
 /**
  * This class owns the sync sources. For historic reasons (required
@@ -1359,10 +1475,8 @@ public:
                      it != dirs.rend();
                      ++it) {
                     const string &sessiondir = *it;
-                    boost::shared_ptr<LogDir> oldsession(LogDir::create(m_client));
-                    oldsession->openLogdir(sessiondir);
                     SyncReport report;
-                    oldsession->readReport(report);
+                    m_logdir->readSessionReport(sessiondir, report);
                     if (report.find(source->getName()) != report.end())  {
                         // source was active in that session, use dump
                         // made there
@@ -2347,6 +2461,15 @@ public:
 
     /** search file system for XML config fragments */
     void scan(const string &mode);
+
+    /**
+     * Describes the current state of all directories that scan()
+     * would look at, without reading them. Empty if the result of
+     * scan() must not be cached, which is the case when
+     * SYNCEVOLUTION_XML_CONFIG_DIR is set or some directory was
+     * modified so recently that further changes might go unnoticed.
+     */
+    static string getCacheKey(const string &mode);
     /** datatypes, scripts and rules concatenated, empty if none found */
     string get(Category category);
     /** main file, typically "syncevolution.xml", empty if not found */
@@ -2375,6 +2498,9 @@ private:
      * add all .xml files to the right hash, overwriting old entries
      */
     void addFragments(const string &dir, Category category);
+
+    /** directories searched by scanRoot() and scanFragments() */
+    static void getDirs(const string &mode, const string &root, std::list<string> &dirs);
 };
 
 const string XMLFiles::m_syncevolutionXML("syncevolution.xml");
@@ -2394,6 +2520,48 @@ void XMLFiles::scan(const string &mode)
     }
 }
 
+void XMLFiles::getDirs(const string &mode, const string &root, std::list<string> &dirs)
+{
+    static const char * const subdirs[] = { "/scripting", "/datatypes", "/remoterules" };
+    dirs.push_back(root);
+    BOOST_FOREACH (const char *sub, subdirs) {
+        dirs.push_back(root + sub);
+        dirs.push_back(root + sub + "/" + mode);
+    }
+}
+
+string XMLFiles::getCacheKey(const string &mode)
+{
+    if (getenv("SYNCEVOLUTION_XML_CONFIG_DIR")) {
+        // Testing, files are likely to be edited in place.
+        return "";
+    }
+
+    std::list<string> dirs;
+    getDirs(mode, XML_CONFIG_DIR, dirs);
+    getDirs(mode, SubstEnvironment("${XDG_CONFIG_HOME}/syncevolution-xml"), dirs);
+
+    // Adding, removing or replacing a fragment (as done by package
+    // updates) changes the modification time of its directory.
+    // Time stamps only have a resolution of seconds, so don't trust
+    // anything modified in the current second.
+    time_t now = time(NULL);
+    std::ostringstream key;
+    key << "SyncEvolution " << VERSION << " " << mode << "\n";
+    BOOST_FOREACH (const string &dir, dirs) {
+        struct stat buf;
+        if (!stat(dir.c_str(), &buf)) {
+            if (buf.st_mtime >= now) {
+                return "";
+            }
+            key << dir << " " << (long)buf.st_mtime << "\n";
+        } else {
+            key << dir << " -\n";
+        }
+    }
+    return key.str();
+}
+
 void XMLFiles::scanRoot(const string &mode, const string &dir)
 {
     addFragments(dir, MAIN);
@@ -2484,11 +2652,75 @@ template <class T> void substTag(string &xml, const string &tagname, const T rep
     substTag(xml, tagname, str.str(), replaceElement);
 }
 
+/**
+ * Stores the template assembled by getConfigTemplateXML() in
+ * ${XDG_CACHE_HOME}/syncevolution/xml-<mode>, together with the key
+ * from XMLFiles::getCacheKey() that it was created for. Format:
+ * "<key size> <xml size> <rules size>\n<key><xml><rules>".
+ */
+static string XMLCacheFile(const string &mode)
+{
+    return SubstEnvironment("${XDG_CACHE_HOME}/syncevolution/xml-" + mode);
+}
+
+static bool ReadXMLCache(const string &mode, const string &key, string &xml, string &rules)
+{
+    string content;
+    if (key.empty() ||
+        !ReadFile(XMLCacheFile(mode), content)) {
+        return false;
+    }
+    unsigned long keySize, xmlSize, rulesSize;
+    int header;
+    if (sscanf(content.c_str(), "%lu %lu %lu\n%n", &keySize, &xmlSize, &rulesSize, &header) != 3 ||
+        header + keySize + xmlSize + rulesSize != content.size() ||
+        content.compare(header, keySize, key)) {
+        return false;
+    }
+    xml = content.substr(header + keySize, xmlSize);
+    rules = content.substr(header + keySize + xmlSize);
+    return true;
+}
+
+static void WriteXMLCache(const string &mode, const string &key, const string &xml, const string &rules)
+{
+    if (key.empty()) {
+        return;
+    }
+    try {
+        string filename = XMLCacheFile(mode);
+        string tmpname = StringPrintf("%s.%ld", filename.c_str(), (long)getpid());
+        mkdir_p(getDirname(filename));
+        {
+            ofstream out(tmpname.c_str());
+            out << (unsigned long)key.size() << " " << (unsigned long)xml.size() << " " << (unsigned long)rules.size() << "\n"
+                << key << xml << rules;
+            out.close();
+            if (out.fail() ||
+                rename(tmpname.c_str(), filename.c_str())) {
+                unlink(tmpname.c_str());
+                SE_THROW("writing " + filename + " failed");
+            }
+        }
+    } catch (...) {
+        // Not fatal, next sync simply has to read the files again.
+        Exception::handle(HANDLE_EXCEPTION_NO_ERROR);
+    }
+}
+
 void SyncContext::getConfigTemplateXML(const string &mode,
                                        string &xml,
                                        string &rules,
                                        string &configname)
 {
+    // Reading all fragments is slow on some devices, reuse the
+    // result of a previous run if nothing changed since then.
+    string key = XMLFiles::getCacheKey(mode);
+    if (ReadXMLCache(mode, key, xml, rules)) {
+        configname = "XML configuration files";
+        return;
+    }
+
     XMLFiles files;
 
     files.scan(mode);
@@ -2507,6 +2739,7 @@ void SyncContext::getConfigTemplateXML(const string &mode,
                  files.get(XMLFiles::DATATYPES) +
                  "    <fieldlists/>\n    <profiles/>\n    <datatypedefs/>\n");
         substTag(xml, "scripting", files.get(XMLFiles::SCRIPTING));
+        WriteXMLCache(mode, key, xml, rules);
     }
 }
 
@@ -3109,21 +3342,92 @@ SyncContext::analyzeSyncMLMessage(const char *data, size_t len,
     return info;
 }
 
+namespace {
+    /**
+     * Engines which were initialized by SyncContext::initEngine() and
+     * are not in use at the moment, most recently used one first.
+     * Parsing the XML configuration is a considerable part of
+     * starting a sync, which can be avoided when the same process
+     * runs the same kind of sync again, for example when a server
+     * analyzes the initial message of each new client session.
+     *
+     * Allocated once and never freed, to avoid destructing engines
+     * while the process shuts down.
+     */
+    typedef std::list< std::pair<std::string, SharedEngine> > EngineCache_t;
+    EngineCache_t &EngineCache()
+    {
+        static EngineCache_t *cache = new EngineCache_t;
+        return *cache;
+    }
+
+    size_t EngineCacheSize()
+    {
+        static const char *size = getenv("SYNCEVOLUTION_ENGINE_CACHE");
+        return size ? atoi(size) : 2;
+    }
+}
+
+void SyncContext::cacheEngine()
+{
+    if (m_engineCacheKey.empty() || !m_engine.get()) {
+        return;
+    }
+    EngineCache_t &cache = EngineCache();
+    cache.push_front(std::make_pair(m_engineCacheKey, m_engine));
+    while (cache.size() > EngineCacheSize()) {
+        cache.pop_back();
+    }
+    m_engineCacheKey.clear();
+}
+
 void SyncContext::initEngine(bool isSync)
 {
     string xml, configname;
     getConfigXML(isSync, xml, configname);
-    try {
-        m_engine.InitEngineXML(xml.c_str());
-    } catch (const BadSynthesisResult &ex) {
-        SE_LOG_ERROR(NULL,
-                     "internal error, invalid XML configuration (%s):\n%s",
-                     m_sourceListPtr && !m_sourceListPtr->empty() ?
-                     "with datastores" :
-                     "without datastores",
-                     xml.c_str());
-        throw;
+
+    // The engine was configured by createEngine() before parsing the
+    // XML, so its config variables must match, too.
+    std::string key;
+    if (EngineCacheSize()) {
+        SharedKey configvars = m_engine.OpenKeyByPath(SharedKey(), "/configvars");
+        key = m_engine.GetStrValue(configvars, "defout_path") + "\n" +
+            m_engine.GetStrValue(configvars, "binfilepath") + "\n" +
+            xml;
+        try {
+            key = SHA_256(key);
+        } catch (...) {
+            // SHA-256 not available, compare the full content instead.
+        }
     }
+
+    EngineCache_t &cache = EngineCache();
+    EngineCache_t::iterator it = cache.begin();
+    while (it != cache.end() && it->first != key) {
+        ++it;
+    }
+    if (!key.empty() && it != cache.end()) {
+        SE_LOG_DEBUG(NULL, "reusing Synthesis engine with the same configuration");
+        SharedEngine engine = it->second;
+        cache.erase(it);
+        cacheEngine();
+        m_engine = engine;
+    } else {
+        // Reinitializing the engine invalidates its old key.
+        m_engineCacheKey.clear();
+        try {
+            m_engine.InitEngineXML(xml.c_str());
+        } catch (const BadSynthesisResult &ex) {
+            SE_LOG_ERROR(NULL,
+                         "internal error, invalid XML configuration (%s):\n%s",
+                         m_sourceListPtr && !m_sourceListPtr->empty() ?
+                         "with datastores" :
+                         "without datastores",
+                         xml.c_str());
+            throw;
+        }
+    }
+    m_engineCacheKey = key;
     if (isSync &&
         getLogLevel() >= 5) {
         SE_LOG_DEV(NULL, "Full XML configuration:\n%s", xml.c_str());
@@ -3386,6 +3690,13 @@ SyncMLStatus SyncContext::sync(SyncReport *report)
          * */
         if ( getPeerIsClient()) {
             m_serverMode = true;
+            if (m_localSync && !m_agent) {
+                // Fork the local sync child now, so that it starts up
+                // and loads its backends while we prepare our own
+                // side of the sync. It gets asked to sync once
+                // doSync() waits for its first message.
+                m_agent = createTransportAgent();
+            }
         } else if (m_localSync && !m_agent) {
             Exception::throwError(SE_HERE, "configuration error, syncURL = local can only be used in combination with peerIsClient = 1");
         }
@@ -4713,11 +5024,33 @@ void SyncContext::getSessions(vector<string> &dirs)
 string SyncContext::readSessionInfo(const string &dir, SyncReport &report)
 {
     boost::shared_ptr<LogDir> logging(LogDir::create(*this));
-    logging->openLogdir(dir);
-    logging->readReport(report);
+    logging->readSessionReport(dir, report);
     return logging->getPeerNameFromLogdir(dir);
 }
 
+void SyncContext::readSessionInfos(size_t start, size_t count,
+                                   vector<string> &dirs,
+                                   vector<string> &peers,
+                                   vector<SyncReport> &reports)
+{
+    boost::shared_ptr<LogDir> logging(LogDir::create(*this));
+    vector<string> all;
+    logging->previousLogdirs(all);
+
+    dirs.clear();
+    peers.clear();
+    reports.clear();
+    for (size_t index = start;
+         index < all.size() && dirs.size() < count;
+         index++) {
+        const string &dir = all[all.size() - 1 - index];
+        dirs.push_back(dir);
+        peers.push_back(logging->getPeerNameFromLogdir(dir));
+        reports.push_back(SyncReport());
+        logging->readSessionReport(dir, reports.back());
+    }
+}
+
 #ifdef ENABLE_UNIT_TESTS
 /**
  * This class works LogDirTest as scratch directory.
@@ -4876,6 +5209,7 @@ private:
     CPPUNIT_TEST(testSessionChanges);
     CPPUNIT_TEST(testMultipleSessions);
     CPPUNIT_TEST(testExpire);
+    CPPUNIT_TEST(testIndex);
     CPPUNIT_TEST_SUITE_END();
 
     /**
@@ -4950,7 +5284,10 @@ private:
         string logdir = getLogDir();
         ReadDir dirs(logdir);
         BOOST_FOREACH(const string &dir, dirs) {
-            sessions.push_back(RealPath(logdir + "/" + dir));
+            // skip session index
+            if (isDir(logdir + "/" + dir)) {
+                sessions.push_back(RealPath(logdir + "/" + dir));
+            }
         }
         sort(sessions.begin(), sessions.end());
         return sessions;
@@ -5076,6 +5413,64 @@ private:
                                                      seconddir, "before"));
     }
 
+    void testIndex() {
+        ScopedEnvChange config("XDG_CONFIG_HOME", "LogDirTest/config");
+        ScopedEnvChange cache("XDG_CACHE_HOME", "LogDirTest/cache");
+
+        string dir = session(false, STATUS_OK, "file_event", ".one", ".two", (char *)0);
+        string seconddir = session(false, STATUS_FATAL, "file_contact", ".two", ".one", (char *)0);
+        string logdir = getLogDir();
+        CPPUNIT_ASSERT(!access((logdir + "/session-index.ini").c_str(), F_OK));
+
+        // index and status.ini must have the same content
+        SyncReport indexed, expected;
+        m_logContext->readSessionInfo(seconddir, indexed);
+        {
+            boost::shared_ptr<ConfigNode> filenode(new IniFileConfigNode(seconddir, "status.ini", true));
+            SafeConfigNode status(filenode);
+            status.setMode(false);
+            status >> expected;
+        }
+        CPPUNIT_ASSERT_EQUAL(SyncMLStatus(STATUS_FATAL), indexed.getStatus());
+        CPPUNIT_ASSERT_EQUAL(expected.getStart(), indexed.getStart());
+        CPPUNIT_ASSERT_EQUAL(expected.getEnd(), indexed.getEnd());
+        CPPUNIT_ASSERT_EQUAL(expected.getError(), indexed.getError());
+        CPPUNIT_ASSERT_EQUAL(expected.size(), indexed.size());
+        CPPUNIT_ASSERT_EQUAL(expected.getSyncSourceReport("file_contact").m_backupAfter.getNumItems(),
+                             indexed.getSyncSourceReport("file_contact").m_backupAfter.getNumItems());
+
+        // status.ini is not needed anymore...
+        CPPUNIT_ASSERT(!unlink((dir + "/status.ini").c_str()));
+        vector<string> dirs, peers;
+        vector<SyncReport> reports;
+        m_logContext->readSessionInfos(0, 10, dirs, peers, reports);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, dirs.size());
+        CPPUNIT_ASSERT_EQUAL(seconddir, dirs[0]);
+        CPPUNIT_ASSERT_EQUAL(dir, dirs[1]);
+        CPPUNIT_ASSERT_EQUAL(SyncMLStatus(STATUS_OK), reports[1].getStatus());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, reports[1].size());
+
+        // ... and paging works
+        m_logContext->readSessionInfos(1, 1, dirs, peers, reports);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, dirs.size());
+        CPPUNIT_ASSERT_EQUAL(dir, dirs[0]);
+
+        // expiring sessions removes them from the index
+        m_maxLogDirs = 1;
+        string thirddir = session(false, STATUS_OK,
+                                  "file_event", ".two", ".one",
+                                  "file_contact", ".two", ".one",
+                                  (char *)0);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, listSessions().size());
+        IniHashConfigNode index(logdir, "session-index.ini", true);
+        ConfigProps props;
+        index.readProperties(props);
+        CPPUNIT_ASSERT(!props.empty());
+        BOOST_FOREACH(const ConfigProps::value_type &entry, props) {
+            CPPUNIT_ASSERT(boost::starts_with(entry.first, getBasename(thirddir) + "/"));
+        }
+    }
+
     void testExpire() {
         ScopedEnvChange config("XDG_CONFIG_HOME", "LogDirTest/config");
         ScopedEnvChange cache("XDG_CACHE_HOME", "LogDirTest/cache");
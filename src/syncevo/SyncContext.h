@@ -116,6 +116,13 @@ class SyncContext : public SyncConfig {
      */
     SharedEngine m_engine;
 
+    /**
+     * Identifies the configuration that m_engine was initialized
+     * with by initEngine(), empty if the engine must not be reused
+     * by other syncs. See cacheEngine().
+     */
+    std::string m_engineCacheKey;
+
     /**
      * Synthesis session handle. Only valid while sync is running.
      */
@@ -359,6 +366,22 @@ class SyncContext : public SyncConfig {
      */
     string readSessionInfo(const string &dir, SyncReport &report);
 
+    /**
+     * Combines getSessions() and readSessionInfo() for a range of
+     * sessions, newest one first. Reads the session index only once
+     * and status.ini files only for sessions not found there.
+     *
+     * @param start     number of newest sessions to skip
+     * @param count     maximum number of sessions to return
+     * @retval dirs     absolute path of each session
+     * @retval peers    peer name encoded in each session dir
+     * @retval reports  information about each session
+     */
+    void readSessionInfos(size_t start, size_t count,
+                          vector<string> &dirs,
+                          vector<string> &peers,
+                          vector<SyncReport> &reports);
+
     /**
      * fills report with information about local changes
      *
@@ -484,10 +507,20 @@ class SyncContext : public SyncConfig {
         }
 
         ~SwapEngine() {
+            m_client.cacheEngine();
             m_client.swapEngine(m_oldengine);
         }
     };
 
+    /**
+     * Hand the current engine over to the process-wide cache of
+     * initialized engines if initEngine() allowed that. initEngine()
+     * then picks it up again when asked to create an engine with the
+     * same configuration. The current engine must not be used
+     * anymore after calling this.
+     */
+    void cacheEngine();
+
     /**
      * Create a Synthesis engine for the currently active
      * sources (might be empty!) and settings.
@@ -36,6 +36,8 @@
 
 #include <synthesis/syerror.h>
 
+#include "test.h"
+
 #include <syncevo/declarations.h>
 using namespace std;
 SE_BEGIN_CXX
@@ -657,6 +659,11 @@ namespace {
 
 SyncReport::SyncReport(const std::string &dump)
 {
+    if (isBinary(dump.c_str(), dump.size())) {
+        fromBinary(dump.c_str(), dump.size());
+        return;
+    }
+
     boost::shared_ptr<std::string> data(new std::string(dump));
     boost::shared_ptr<StringDataBlob> blob(new StringDataBlob("sync report",
                                                               data,
@@ -677,6 +684,176 @@ std::string SyncReport::toString() const
     return *data;
 }
 
+namespace {
+    /**
+     * Binary format, version 1. All integers are in host byte order,
+     * strings are stored as 32 bit length plus bytes:
+     * - header "\0SR" + version byte
+     * - start, end (int64), status (int32), error, local name, remote name
+     * - number of sources (uint32), followed by per source:
+     *   name, mode, restarts, status, received, sent (int32),
+     *   first, resume (uint8), virtual source, backup before/after (int64),
+     *   dimensions of the statistics (3 x uint8) and the statistics (int32)
+     *
+     * The NUL byte at the start can never occur in the text format.
+     */
+    const char BINARY_HEADER[] = { '\0', 'S', 'R' };
+    const char BINARY_VERSION = 1;
+
+    template<class T> void appendBinary(std::string &buffer, T value)
+    {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void appendBinary(std::string &buffer, const std::string &str)
+    {
+        appendBinary(buffer, static_cast<uint32_t>(str.size()));
+        buffer.append(str);
+    }
+
+    class BinaryReader
+    {
+        const char *m_data;
+        size_t m_size;
+
+        const char *consume(size_t size)
+        {
+            if (size > m_size) {
+                SE_THROW("truncated binary sync report");
+            }
+            const char *data = m_data;
+            m_data += size;
+            m_size -= size;
+            return data;
+        }
+
+    public:
+        BinaryReader(const char *data, size_t size) : m_data(data), m_size(size) {}
+
+        template<class T> T get()
+        {
+            T value;
+            memcpy(&value, consume(sizeof(value)), sizeof(value));
+            return value;
+        }
+
+        std::string getString()
+        {
+            uint32_t size = get<uint32_t>();
+            return std::string(consume(size), size);
+        }
+    };
+}
+
+bool SyncReport::isBinary(const char *data, size_t size)
+{
+    return size > sizeof(BINARY_HEADER) &&
+        !memcmp(data, BINARY_HEADER, sizeof(BINARY_HEADER));
+}
+
+std::string SyncReport::toBinary() const
+{
+    std::string buffer;
+    buffer.append(BINARY_HEADER, sizeof(BINARY_HEADER));
+    appendBinary(buffer, BINARY_VERSION);
+    appendBinary(buffer, static_cast<int64_t>(m_start));
+    appendBinary(buffer, static_cast<int64_t>(m_end));
+    appendBinary(buffer, static_cast<int32_t>(m_status));
+    appendBinary(buffer, m_error);
+    appendBinary(buffer, m_localName);
+    appendBinary(buffer, m_remoteName);
+
+    appendBinary(buffer, static_cast<uint32_t>(size()));
+    BOOST_FOREACH(const value_type &entry, *this) {
+        const SyncSourceReport &source = entry.second;
+        appendBinary(buffer, entry.first);
+        appendBinary(buffer, static_cast<int32_t>(source.getFinalSyncMode()));
+        appendBinary(buffer, static_cast<int32_t>(source.getRestarts()));
+        appendBinary(buffer, static_cast<int32_t>(source.getStatus()));
+        appendBinary(buffer, static_cast<int32_t>(source.getTotalNumItemsReceived()));
+        appendBinary(buffer, static_cast<int32_t>(source.getTotalNumItemsSent()));
+        appendBinary(buffer, static_cast<uint8_t>(source.isFirstSync()));
+        appendBinary(buffer, static_cast<uint8_t>(source.isResumeSync()));
+        appendBinary(buffer, source.getVirtualSource());
+        appendBinary(buffer, static_cast<int64_t>(source.m_backupBefore.getNumItems()));
+        appendBinary(buffer, static_cast<int64_t>(source.m_backupAfter.getNumItems()));
+        appendBinary(buffer, static_cast<uint8_t>(SyncSourceReport::ITEM_LOCATION_MAX));
+        appendBinary(buffer, static_cast<uint8_t>(SyncSourceReport::ITEM_STATE_MAX));
+        appendBinary(buffer, static_cast<uint8_t>(SyncSourceReport::ITEM_RESULT_MAX));
+        for (int location = 0;
+             location < SyncSourceReport::ITEM_LOCATION_MAX;
+             location++) {
+            for (int state = 0;
+                 state < SyncSourceReport::ITEM_STATE_MAX;
+                 state++) {
+                for (int result = 0;
+                     result < SyncSourceReport::ITEM_RESULT_MAX;
+                     result++) {
+                    appendBinary(buffer,
+                                 static_cast<int32_t>(source.getItemStat(SyncSourceReport::ItemLocation(location),
+                                                                         SyncSourceReport::ItemState(state),
+                                                                         SyncSourceReport::ItemResult(result))));
+                }
+            }
+        }
+    }
+    return buffer;
+}
+
+void SyncReport::fromBinary(const char *data, size_t size)
+{
+    if (!isBinary(data, size)) {
+        SE_THROW("not a binary sync report");
+    }
+    BinaryReader reader(data + sizeof(BINARY_HEADER), size - sizeof(BINARY_HEADER));
+    char version = reader.get<char>();
+    if (version != BINARY_VERSION) {
+        SE_THROW(StringPrintf("binary sync report has unsupported version %d", version));
+    }
+
+    clear();
+    m_start = static_cast<time_t>(reader.get<int64_t>());
+    m_end = static_cast<time_t>(reader.get<int64_t>());
+    m_status = static_cast<SyncMLStatus>(reader.get<int32_t>());
+    m_error = reader.getString();
+    m_localName = reader.getString();
+    m_remoteName = reader.getString();
+
+    uint32_t numSources = reader.get<uint32_t>();
+    for (uint32_t i = 0; i < numSources; i++) {
+        SyncSourceReport &source = getSyncSourceReport(reader.getString());
+        source.recordFinalSyncMode(static_cast<SyncMode>(reader.get<int32_t>()));
+        source.setRestarts(reader.get<int32_t>());
+        source.recordStatus(static_cast<SyncMLStatus>(reader.get<int32_t>()));
+        source.recordTotalNumItemsReceived(reader.get<int32_t>());
+        source.recordTotalNumItemsSent(reader.get<int32_t>());
+        source.recordFirstSync(reader.get<uint8_t>());
+        source.recordResumeSync(reader.get<uint8_t>());
+        source.recordVirtualSource(reader.getString());
+        source.m_backupBefore.setNumItems(static_cast<long>(reader.get<int64_t>()));
+        source.m_backupAfter.setNumItems(static_cast<long>(reader.get<int64_t>()));
+        int locations = reader.get<uint8_t>();
+        int states = reader.get<uint8_t>();
+        int results = reader.get<uint8_t>();
+        for (int location = 0; location < locations; location++) {
+            for (int state = 0; state < states; state++) {
+                for (int result = 0; result < results; result++) {
+                    int32_t value = reader.get<int32_t>();
+                    // ignore statistics unknown to this version
+                    if (location < SyncSourceReport::ITEM_LOCATION_MAX &&
+                        state < SyncSourceReport::ITEM_STATE_MAX &&
+                        result < SyncSourceReport::ITEM_RESULT_MAX) {
+                        source.setItemStat(SyncSourceReport::ItemLocation(location),
+                                           SyncSourceReport::ItemState(state),
+                                           SyncSourceReport::ItemResult(result),
+                                           value);
+                    }
+                }
+            }
+        }
+    }
+}
+
 void SyncReport::prettyPrint(std::ostream &out, int flags) const
 {
     // table looks like this:
@@ -1184,4 +1361,51 @@ ConfigNode &operator >> (ConfigNode &node, SyncReport &report)
     return node;
 }
 
+#ifdef ENABLE_UNIT_TESTS
+
+class SyncReportTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(SyncReportTest);
+    CPPUNIT_TEST(binary);
+    CPPUNIT_TEST_SUITE_END();
+
+    void binary()
+    {
+        SyncReport report;
+        report.setStart(1234);
+        report.setEnd(5678);
+        report.setStatus(STATUS_PARTIAL_FAILURE);
+        report.setError("some error\nwith two lines");
+        SyncSourceReport &source = report.getSyncSourceReport("addressbook");
+        source.recordFinalSyncMode(SYNC_SLOW);
+        source.setRestarts(2);
+        source.recordFirstSync(true);
+        source.recordStatus(STATUS_FATAL);
+        source.recordVirtualSource("calendar+todo");
+        source.m_backupBefore.setNumItems(10);
+        source.setItemStat(SyncSourceReport::ITEM_REMOTE,
+                           SyncSourceReport::ITEM_UPDATED,
+                           SyncSourceReport::ITEM_TOTAL,
+                           5);
+        report.getSyncSourceReport("calendar");
+
+        std::string binary = report.toBinary();
+        CPPUNIT_ASSERT(SyncReport::isBinary(binary.c_str(), binary.size()));
+        CPPUNIT_ASSERT(!SyncReport::isBinary(report.toString().c_str(), report.toString().size()));
+
+        // must be identical to the text format
+        SyncReport copy(binary);
+        CPPUNIT_ASSERT_EQUAL(report.toString(), copy.toString());
+        CPPUNIT_ASSERT_EQUAL(report.toString(), SyncReport(report.toString()).toString());
+
+        // incomplete data must be detected
+        CPPUNIT_ASSERT_THROW(copy.fromBinary(binary.c_str(), binary.size() - 1), Exception);
+        binary[3] = 2;
+        CPPUNIT_ASSERT_THROW(copy.fromBinary(binary.c_str(), binary.size()), Exception);
+    }
+};
+
+SYNCEVOLUTION_TEST_SUITE_REGISTRATION(SyncReportTest);
+
+#endif // ENABLE_UNIT_TESTS
+
 SE_END_CXX
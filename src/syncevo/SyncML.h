@@ -475,12 +475,30 @@ class SyncReport : public std::map<std::string, SyncSourceReport> {
         m_remoteName("REMOTE")
         {}
 
-    /** construct from text dump */
+    /** construct from text dump or toBinary() result */
     SyncReport(const std::string &dump);
 
     /** convert to text dump */
     std::string toString() const;
 
+    /**
+     * Convert to a compact, versioned binary representation which
+     * can be decoded again without parsing text. Meant for passing
+     * reports between processes on the same host; the byte order
+     * is the one of the host. Files on disk continue to use the
+     * text format.
+     */
+    std::string toBinary() const;
+
+    /**
+     * Replace content with the result of toBinary(). Throws an
+     * error for unknown versions and truncated data.
+     */
+    void fromBinary(const char *data, size_t size);
+
+    /** true if the data was produced by toBinary() */
+    static bool isBinary(const char *data, size_t size);
+
     void setLocalName(const std::string &name) { m_localName = name; }
     void setRemoteName(const std::string &name) { m_remoteName = name; }
 
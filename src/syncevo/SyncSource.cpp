@@ -48,6 +48,7 @@
 
 #ifdef ENABLE_UNIT_TESTS
 #include "test.h"
+#include <syncevo/VolatileConfigNode.h>
 #endif
 
 #include <syncevo/declarations.h>
@@ -709,9 +710,25 @@ void SyncSourceDelete::init(SyncSource::Operations &ops)
     ops.m_deleteItem = boost::bind(&SyncSourceDelete::deleteItemSynthesis, this, _1);
 }
 
-sysync::TSyError SyncSourceDelete::deleteItemSynthesis(sysync::cItemID aID)
+SyncSource::Operations::DeleteItemResult_t SyncSourceDelete::deleteItemSynthesis(sysync::cItemID aID)
 {
-    deleteItem(aID->item);
+    DeleteItemCheck_t check = deleteItemAsync(aID->item);
+    if (check) {
+        return SyncSource::Operations::DeleteItemContinue_t(boost::bind(&SyncSourceDelete::deleteContinue, this, check));
+    }
+    incrementNumDeleted();
+    return sysync::LOCERR_OK;
+}
+
+sysync::TSyError SyncSourceDelete::deleteContinue(const DeleteItemCheck_t &check)
+{
+    // Same reasoning as in SyncSourceSerialize::insertContinue().
+    flushItemChanges();
+    finishItemChanges();
+
+    if (!check()) {
+        return sysync::LOCERR_AGAIN;
+    }
     incrementNumDeleted();
     return sysync::LOCERR_OK;
 }
@@ -1174,6 +1191,60 @@ void SyncSourceRevisions::backupData(const SyncSource::Operations::ConstBackupIn
     cache.finalize(report);
 }
 
+/**
+ * An item change started by SyncSourceRevisions::restoreData()
+ * which has not completed yet.
+ */
+struct PendingRestore
+{
+    SyncSourceReport::ItemState m_state;
+    SyncSourceRaw::InsertItemResult m_insert;
+    SyncSourceDelete::DeleteItemCheck_t m_delete;
+};
+
+/**
+ * Number of asynchronous item changes which restoreData() starts
+ * before waiting for them.
+ */
+static const size_t RESTORE_BATCH_SIZE = 50;
+
+/**
+ * Wait until all pending item changes have completed. Errors are
+ * counted as rejected items and then passed on, as for
+ * synchronous changes.
+ */
+static void FinishRestore(SyncSourceBase &source,
+                          std::vector<PendingRestore> &pending,
+                          SyncSourceReport &report)
+{
+    while (!pending.empty()) {
+        source.flushItemChanges();
+        source.finishItemChanges();
+
+        std::vector<PendingRestore> again;
+        BOOST_FOREACH (PendingRestore &change, pending) {
+            try {
+                if (change.m_delete) {
+                    if (!change.m_delete()) {
+                        again.push_back(change);
+                    }
+                } else {
+                    change.m_insert = change.m_insert.m_continue();
+                    if (change.m_insert.m_state == ITEM_AGAIN) {
+                        again.push_back(change);
+                    }
+                }
+            } catch (...) {
+                report.incrementItemStat(report.ITEM_LOCAL,
+                                         change.m_state,
+                                         report.ITEM_REJECT);
+                throw;
+            }
+        }
+        pending.swap(again);
+    }
+}
+
 void SyncSourceRevisions::restoreData(const SyncSource::Operations::ConstBackupInfo &oldBackup,
                                       bool dryrun,
                                       SyncSourceReport &report)
@@ -1187,6 +1258,11 @@ void SyncSourceRevisions::restoreData(const SyncSource::Operations::ConstBackupI
     stringstream stream(strval);
     stream >> numitems;
 
+    // Item changes are started without waiting for their completion
+    // if the backend supports that, then completed in batches. Only
+    // the data of the current batch is kept in memory.
+    std::vector<PendingRestore> pending;
+
     for (long counter = 1; counter <= numitems; counter++) {
         stringstream key;
         key << counter << "-uid";
@@ -1231,8 +1307,13 @@ void SyncSourceRevisions::restoreData(const SyncSource::Operations::ConstBackupI
                                          state,
                                          report.ITEM_TOTAL);
                 if (!dryrun) {
-                    m_raw->insertItemRaw(it == revisions.end() ? "" : uid,
-                                         data);
+                    PendingRestore change;
+                    change.m_state = state;
+                    change.m_insert = m_raw->insertItemRawAsync(it == revisions.end() ? "" : uid,
+                                                                data);
+                    if (change.m_insert.m_state == ITEM_AGAIN) {
+                        pending.push_back(change);
+                    }
                 }
             } catch (...) {
                 report.incrementItemStat(report.ITEM_LOCAL,
@@ -1240,6 +1321,9 @@ void SyncSourceRevisions::restoreData(const SyncSource::Operations::ConstBackupI
                                          report.ITEM_REJECT);
                 throw;
             }
+            if (pending.size() >= RESTORE_BATCH_SIZE) {
+                FinishRestore(*m_raw, pending, report);
+            }
         }
 
         // remove handled item from revision list so
@@ -1258,7 +1342,12 @@ void SyncSourceRevisions::restoreData(const SyncSource::Operations::ConstBackupI
                                      report.ITEM_REMOVED,
                                      report.ITEM_TOTAL);
             if (!dryrun) {
-                m_del->deleteItem(mapping.first);
+                PendingRestore change;
+                change.m_state = SyncSourceReport::ITEM_REMOVED;
+                change.m_delete = m_del->deleteItemAsync(mapping.first);
+                if (change.m_delete) {
+                    pending.push_back(change);
+                }
             }
         } catch(...) {
             report.incrementItemStat(report.ITEM_LOCAL,
@@ -1266,7 +1355,12 @@ void SyncSourceRevisions::restoreData(const SyncSource::Operations::ConstBackupI
                                      report.ITEM_REJECT);
             throw;
         }
+        if (pending.size() >= RESTORE_BATCH_SIZE) {
+            FinishRestore(*m_raw, pending, report);
+        }
     }
+
+    FinishRestore(*m_raw, pending, report);
 }
 
 bool SyncSourceRevisions::detectChanges(ConfigNode &trackingNode, ChangeMode mode)
@@ -1284,6 +1378,18 @@ bool SyncSourceRevisions::detectChanges(ConfigNode &trackingNode, ChangeMode mod
         m_firstCycle = false;
     }
 
+    if (mode == CHANGES_NONE && m_hashNode) {
+        // The caller cannot know about modifications which left the
+        // revision string unchanged.
+        ConfigProps hashes;
+        m_hashNode->readProperties(hashes);
+        if (!hashes.empty()) {
+            SE_LOG_DEBUG(getDisplayName(), "%ld recently written items need to be checked, doing full item scan",
+                         (long)hashes.size());
+            mode = CHANGES_FULL;
+        }
+    }
+
     if (mode == CHANGES_NONE) {
         // shortcut because nothing changed: just copy our known item list
         ConfigProps props;
@@ -1353,10 +1459,17 @@ bool SyncSourceRevisions::detectChanges(ConfigNode &trackingNode, ChangeMode mod
     // yet).
     StringMap revUpdates;
 
+    // Items whose revision string did not change although it might
+    // have, see enableRevisionHashes().
+    RevisionMap_t unchanged;
+
     if (mode == CHANGES_SLOW) {
         // Make tracking node identical to current set of items
         // by re-adding them below.
         trackingNode.clear();
+        if (m_hashNode) {
+            m_hashNode->clear();
+        }
     }
 
     BOOST_FOREACH(const StringPair &mapping, m_revisions) {
@@ -1379,6 +1492,8 @@ bool SyncSourceRevisions::detectChanges(ConfigNode &trackingNode, ChangeMode mod
                 if (revision != serverRevision) {
                     addItem(uid, UPDATED);
                     revUpdates[uid] = revision;
+                } else if (m_hashNode) {
+                    unchanged[uid] = revision;
                 }
             }
         }
@@ -1401,11 +1516,64 @@ bool SyncSourceRevisions::detectChanges(ConfigNode &trackingNode, ChangeMode mod
         BOOST_FOREACH(const StringPair &update, revUpdates) {
             trackingNode.setProperty(update.first, update.second);
         }
+
+        if (m_hashNode) {
+            checkRevisionHashes(unchanged);
+        }
     }
 
     return forceSlowSync;
 }
 
+std::string SyncSourceRevisions::revisionHash(const std::string &luid)
+{
+    std::string item;
+    m_raw->readItemRaw(luid, item);
+    try {
+        return SHA_256(item);
+    } catch (...) {
+        // SHA-256 not available, fall back to something simpler.
+        return StringPrintf("%lu-%lx", (unsigned long)item.size(), Hash(item));
+    }
+}
+
+void SyncSourceRevisions::checkRevisionHashes(const RevisionMap_t &unchanged)
+{
+    ConfigProps hashes;
+    m_hashNode->readProperties(hashes);
+    m_hashNode->clear();
+    time_t now = time(NULL);
+
+    BOOST_FOREACH(const StringPair &entry, hashes) {
+        const std::string &uid = entry.first;
+        if (unchanged.find(uid) == unchanged.end()) {
+            // Deleted or with a new revision string, both already
+            // detected above.
+            continue;
+        }
+
+        // "<time of modification> <hash>"
+        const std::string &value = entry.second;
+        size_t sep = value.find(' ');
+        if (sep == value.npos) {
+            continue;
+        }
+        time_t modified = atol(value.substr(0, sep).c_str());
+        std::string hash = revisionHash(uid);
+        if (hash != value.substr(sep + 1)) {
+            SE_LOG_DEBUG(getDisplayName(), "item %s modified without changing its revision %s",
+                         uid.c_str(), unchanged.find(uid)->second.c_str());
+            addItem(uid, UPDATED);
+        }
+
+        // The revision string might still stay the same for further
+        // modifications until the granularity has passed.
+        if (now <= modified + m_revisionAccuracySeconds) {
+            m_hashNode->setProperty(uid, StringPrintf("%ld %s", (long)modified, hash.c_str()));
+        }
+    }
+}
+
 void SyncSourceRevisions::updateRevision(ConfigNode &trackingNode,
                                          const std::string &old_luid,
                                          const std::string &new_luid,
@@ -1415,10 +1583,11 @@ void SyncSourceRevisions::updateRevision(ConfigNode &trackingNode,
         return;
     }
 
-    databaseModified();
     if (old_luid != new_luid) {
         trackingNode.removeProperty(old_luid);
+        m_itemModTimeStamps.erase(old_luid);
     }
+    databaseModified(new_luid);
     if (new_luid.empty() || revision.empty()) {
         throwError(SE_HERE, "need non-empty LUID and revision string");
     }
@@ -1433,10 +1602,45 @@ void SyncSourceRevisions::deleteRevision(ConfigNode &trackingNode,
     }
     databaseModified();
     trackingNode.removeProperty(luid);
+    m_itemModTimeStamps.erase(luid);
+}
+
+SyncMLStatus SyncSourceRevisions::storeRevisionHashes(bool success)
+{
+    m_revisionHashesStored = false;
+    if (!m_hashNode || !m_raw || !success) {
+        return STATUS_OK;
+    }
+
+    try {
+        Timespec current = Timespec::monotonic();
+        time_t now = time(NULL);
+        BOOST_FOREACH(const ModTimeStamps_t::value_type &entry, m_itemModTimeStamps) {
+            double age = (current - entry.second).duration();
+            if (age < m_revisionAccuracySeconds) {
+                time_t modified = now - (time_t)age;
+                m_hashNode->setProperty(entry.first,
+                                        StringPrintf("%ld %s", (long)modified, revisionHash(entry.first).c_str()));
+            }
+        }
+        m_revisionHashesStored = true;
+    } catch (...) {
+        std::string explanation;
+        Exception::handle(explanation, HANDLE_EXCEPTION_NO_ERROR);
+        SE_LOG_DEBUG(getDisplayName(), "storing content hashes failed, waiting instead: %s", explanation.c_str());
+    }
+    m_itemModTimeStamps.clear();
+    return STATUS_OK;
 }
 
 SyncMLStatus SyncSourceRevisions::sleepSinceModification()
 {
+    if (m_revisionHashesStored) {
+        // Next detectChanges() will compare hashes.
+        m_revisionHashesStored = false;
+        return STATUS_OK;
+    }
+
     Timespec current = Timespec::monotonic();
     // Don't let this get interrupted by user abort.
     // It is needed for correct change tracking.
@@ -1447,9 +1651,19 @@ SyncMLStatus SyncSourceRevisions::sleepSinceModification()
     return STATUS_OK;
 }
 
-void SyncSourceRevisions::databaseModified()
+void SyncSourceRevisions::databaseModified(const std::string &luid)
 {
     m_modTimeStamp = Timespec::monotonic();
+    if (m_hashNode && !luid.empty()) {
+        m_itemModTimeStamps[luid] = m_modTimeStamp;
+    }
+}
+
+void SyncSourceRevisions::enableRevisionHashes(const boost::shared_ptr<ConfigNode> &hashNode)
+{
+    if (m_raw && m_revisionAccuracySeconds > 0) {
+        m_hashNode = hashNode;
+    }
 }
 
 void SyncSourceRevisions::init(SyncSourceRaw *raw,
@@ -1462,6 +1676,7 @@ void SyncSourceRevisions::init(SyncSourceRaw *raw,
     m_revisionAccuracySeconds = granularity;
     m_revisionsSet = false;
     m_firstCycle = false;
+    m_revisionHashesStored = false;
     if (raw) {
         ops.m_backupData = boost::bind(&SyncSourceRevisions::backupData,
                                        this, _1, _2, _3);
@@ -1470,6 +1685,8 @@ void SyncSourceRevisions::init(SyncSourceRaw *raw,
         ops.m_restoreData = boost::bind(&SyncSourceRevisions::restoreData,
                                         this, _1, _2, _3);
     }
+    ops.m_endDataWrite.getPreSignal().connect(boost::bind(&SyncSourceRevisions::storeRevisionHashes,
+                                                          this, _2));
     ops.m_endDataWrite.getPostSignal().connect(boost::bind(&SyncSourceRevisions::sleepSinceModification,
                                                            this));
 }
@@ -1786,6 +2003,86 @@ class SyncSourceTest : public CppUnit::TestFixture {
 
 SYNCEVOLUTION_TEST_SUITE_REGISTRATION(SyncSourceTest);
 
+/**
+ * Items are kept in memory. The revision string only changes when
+ * the test sets it, like a time stamp which has not advanced yet.
+ */
+class RevisionsTestSource : public DummySyncSource, public SyncSourceRevisions, public SyncSourceRaw
+{
+ public:
+    RevisionsTestSource(const boost::shared_ptr<ConfigNode> &hashNode) :
+        DummySyncSource("revisions", "@default")
+    {
+        SyncSourceRevisions::init(this, NULL, 60, m_operations);
+        enableRevisionHashes(hashNode);
+    }
+
+    std::map<std::string, std::string> m_items;
+    RevisionMap_t m_revisions;
+
+    virtual void listAllItems(RevisionMap_t &revisions) { revisions = m_revisions; }
+    virtual InsertItemResult insertItemRaw(const std::string &luid, const std::string &item)
+    {
+        m_items[luid] = item;
+        return InsertItemResult(luid, m_revisions[luid], ITEM_OKAY);
+    }
+    virtual void readItemRaw(const std::string &luid, std::string &item) { item = m_items[luid]; }
+};
+
+class SyncSourceRevisionsTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(SyncSourceRevisionsTest);
+    CPPUNIT_TEST(sameRevision);
+    CPPUNIT_TEST_SUITE_END();
+
+    /**
+     * An item gets written during a sync and modified again locally
+     * before its revision time stamp changes. Hashes stored at the
+     * end of the sync must catch that, without the sleep.
+     */
+    void sameRevision()
+    {
+        VolatileConfigNode trackingNode;
+        boost::shared_ptr<ConfigNode> hashNode(new VolatileConfigNode);
+
+        // sync: write two items
+        RevisionsTestSource sync(hashNode);
+        sync.m_revisions["a"] = "1000";
+        sync.m_revisions["b"] = "1000";
+        sync.detectChanges(trackingNode, SyncSourceRevisions::CHANGES_SLOW);
+        sync.insertItemRaw("a", "a1");
+        sync.updateRevision(trackingNode, "a", "a", "1000");
+        sync.insertItemRaw("b", "b1");
+        sync.updateRevision(trackingNode, "b", "b", "1000");
+        Timespec start = Timespec::monotonic();
+        sync.getOperations().m_endDataWrite(true, NULL);
+        // hashes instead of sleep
+        CPPUNIT_ASSERT((Timespec::monotonic() - start).duration() < 30);
+
+        // modified twice within the same second, "b" untouched
+        RevisionsTestSource local(hashNode);
+        local.m_revisions = sync.m_revisions;
+        local.m_items = sync.m_items;
+        local.m_items["a"] = "a2";
+        local.m_items["a"] = "a3";
+        local.detectChanges(trackingNode, SyncSourceRevisions::CHANGES_FULL);
+        CPPUNIT_ASSERT_EQUAL(std::string("a b"), boost::join(local.getAllItems(), " "));
+        CPPUNIT_ASSERT_EQUAL(std::string(""), boost::join(local.getNewItems(), " "));
+        CPPUNIT_ASSERT_EQUAL(std::string("a"), boost::join(local.getUpdatedItems(), " "));
+        CPPUNIT_ASSERT_EQUAL(std::string(""), boost::join(local.getDeletedItems(), " "));
+
+        // still within the same second: no change, then another one
+        local.detectChanges(trackingNode, SyncSourceRevisions::CHANGES_FULL);
+        CPPUNIT_ASSERT_EQUAL(std::string(""), boost::join(local.getUpdatedItems(), " "));
+        local.m_items["a"] = "a4";
+        local.detectChanges(trackingNode, SyncSourceRevisions::CHANGES_FULL);
+        CPPUNIT_ASSERT_EQUAL(std::string("a"), boost::join(local.getUpdatedItems(), " "));
+        CPPUNIT_ASSERT_EQUAL(std::string(""), boost::join(local.getNewItems(), " "));
+        CPPUNIT_ASSERT_EQUAL(std::string(""), boost::join(local.getDeletedItems(), " "));
+    }
+};
+
+SYNCEVOLUTION_TEST_SUITE_REGISTRATION(SyncSourceRevisionsTest);
+
 #endif // ENABLE_UNIT_TESTS
 
 
@@ -2397,11 +2397,27 @@ class SyncSourceDelete : virtual public SyncSourceBase {
  public:
     virtual void deleteItem(const string &luid) = 0;
 
+    /**
+     * Returned by deleteItemAsync() when the item is not deleted
+     * yet. Will be called again later to poll for completion:
+     * returns false while the removal is still pending, true once it
+     * is done, and throws the same errors as deleteItem().
+     */
+    typedef ContinueOperation<bool ()> DeleteItemCheck_t;
+
+    /**
+     * Optional: start deleting the item without waiting for the
+     * result. Returns an empty check if the item was deleted right
+     * away. The default implementation calls deleteItem().
+     */
+    virtual DeleteItemCheck_t deleteItemAsync(const string &luid) { deleteItem(luid); return DeleteItemCheck_t(); }
+
     /** set Synthesis DB Interface operations */
     void init(SyncSource::Operations &ops);
 
  private:
-    sysync::TSyError deleteItemSynthesis(sysync::cItemID aID);
+    SyncSource::Operations::DeleteItemResult_t deleteItemSynthesis(sysync::cItemID aID);
+    sysync::TSyError deleteContinue(const DeleteItemCheck_t &check);
 };
 
 enum InsertItemResultState {
@@ -2503,6 +2519,15 @@ class SyncSourceRaw : virtual public SyncSourceBase {
     /** same as SyncSourceSerialize::insertItem(), but with internal format */
     virtual InsertItemResult insertItemRaw(const std::string &luid, const std::string &item) = 0;
 
+    /**
+     * Optional: same as insertItemRaw(), but may return ITEM_AGAIN
+     * together with a check instead of waiting for the result, like
+     * SyncSourceSerialize::insertItem(). The caller must then call
+     * flushItemChanges() and finishItemChanges() before polling.
+     * The default implementation calls insertItemRaw().
+     */
+    virtual InsertItemResult insertItemRawAsync(const std::string &luid, const std::string &item) { return insertItemRaw(luid, item); }
+
     /** same as SyncSourceSerialize::readItem(), but with internal format */
     virtual void readItemRaw(const std::string &luid, std::string &item) = 0;
 };
@@ -2595,6 +2620,7 @@ class SyncSourceSerialize : virtual public SyncSourceBase, virtual public SyncSo
 
     /* implement SyncSourceRaw under the assumption that the internal and engine format are identical */
     virtual InsertItemResult insertItemRaw(const std::string &luid, const std::string &item);
+    virtual InsertItemResult insertItemRawAsync(const std::string &luid, const std::string &item) { return insertItem(luid, item); }
     virtual void readItemRaw(const std::string &luid, std::string &item);
 
     /** set Synthesis DB Interface operations */
@@ -2867,11 +2893,44 @@ class SyncSourceRevisions : virtual public SyncSourceChanges, virtual public Syn
               int granularity,
               SyncSource::Operations &ops);
 
+    /**
+     * Avoid the sleep at the end of a session. Instead, a hash of
+     * the content of items which were written less than the
+     * granularity ago gets stored. The next detectChanges() then
+     * reads these items and compares hashes, because their revision
+     * string might not have changed despite a modification.
+     *
+     * Needs a SyncSourceRaw in init(). Without it, the sleep remains.
+     *
+     * @param hashNode    a config node for exclusive use by this class,
+     *                    must be flushed together with the tracking node
+     */
+    void enableRevisionHashes(const boost::shared_ptr<ConfigNode> &hashNode);
+
  private:
     SyncSourceRaw *m_raw;
     SyncSourceDelete *m_del;
     int m_revisionAccuracySeconds;
 
+    /** see enableRevisionHashes(), NULL if not enabled */
+    boost::shared_ptr<ConfigNode> m_hashNode;
+
+    /** monotonic time of latest modification of each item written in this session */
+    typedef std::map<std::string, Timespec> ModTimeStamps_t;
+    ModTimeStamps_t m_itemModTimeStamps;
+
+    /** true if storeRevisionHashes() made the sleep unnecessary */
+    bool m_revisionHashesStored;
+
+    /** hash of the item content, as stored in m_hashNode */
+    std::string revisionHash(const std::string &luid);
+
+    /** compare stored hashes for items with unchanged revision, then refresh or expire them */
+    void checkRevisionHashes(const RevisionMap_t &unchanged);
+
+    /** at the end of a session, before the tracking node gets flushed */
+    SyncMLStatus storeRevisionHashes(bool success);
+
     /** buffers the result of the initial listAllItems() call */
     RevisionMap_t m_revisions;
     bool m_revisionsSet;
@@ -2898,8 +2957,10 @@ class SyncSourceRevisions : virtual public SyncSourceChanges, virtual public Syn
     /**
      * Increments the time stamp of the latest database modification,
      * called automatically whenever revisions change.
+     *
+     * @param luid    the modified item, empty if not known
      */
-    void databaseModified();
+    void databaseModified(const std::string &luid = "");
 
     /** time stamp of latest database modification, for sleepSinceModification() */
     Timespec m_modTimeStamp;
@@ -31,6 +31,9 @@
 #endif
 
 #include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include <deque>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
@@ -118,9 +121,129 @@ class Cond
     ~Cond() { g_cond_clear(&m_cond); }
 
     void signal() { g_cond_signal(&m_cond); }
+    void broadcast() { g_cond_broadcast(&m_cond); }
     template<class M> void wait(M &m) { g_cond_wait(&m_cond, m); }
 };
 
+/**
+ * Queue of work items which get processed by worker threads in the
+ * order in which they were added. The owner starts the threads and
+ * calls run() in each of them, adds items with push() and waits for
+ * them with wait() or finish().
+ *
+ * T must have a "bool m_done" member which is false when the item
+ * gets pushed. The queue sets it while holding its lock; use
+ * isDone() to read it.
+ */
+template<class T> class WorkQueue : private boost::noncopyable
+{
+ public:
+    WorkQueue() :
+        m_idle(0),
+        m_numPending(0),
+        m_shutdown(false)
+    {}
+
+    /**
+     * Add an item.
+     *
+     * @return true if no worker is waiting for work, in which case
+     *         the owner may want to start another one
+     */
+    bool push(const boost::shared_ptr<T> &item)
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        m_queue.push_back(item);
+        m_numPending++;
+        m_workAvailable.signal();
+        return !m_idle;
+    }
+
+    /** true if the item was processed */
+    bool isDone(const boost::shared_ptr<T> &item)
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        return item->m_done;
+    }
+
+    /** wait until the item was processed */
+    void wait(const boost::shared_ptr<T> &item)
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        while (!item->m_done) {
+            m_workDone.wait(m_mutex);
+        }
+    }
+
+    /** number of queued or running items */
+    int getNumPending()
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        return m_numPending;
+    }
+
+    /** wait until all items pushed so far were processed */
+    void finish()
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        while (m_numPending) {
+            m_workDone.wait(m_mutex);
+        }
+    }
+
+    /** let run() return once the queue is empty */
+    void shutdown()
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        m_shutdown = true;
+        m_workAvailable.broadcast();
+    }
+
+    /**
+     * Main function of a worker thread: calls process(item) for one
+     * item after the other without holding the lock, until
+     * shutdown() is called. process must not throw exceptions.
+     */
+    template<class F> void run(const F &process)
+    {
+        DynMutex::Guard guard = m_mutex.lock();
+        while (true) {
+            if (m_queue.empty()) {
+                if (m_shutdown) {
+                    break;
+                }
+                m_idle++;
+                m_workAvailable.wait(m_mutex);
+                m_idle--;
+                continue;
+            }
+
+            boost::shared_ptr<T> item = m_queue.front();
+            m_queue.pop_front();
+            guard.unlock();
+            process(*item);
+            guard = m_mutex.lock();
+            item->m_done = true;
+            m_numPending--;
+            m_workDone.broadcast();
+        }
+    }
+
+ private:
+    /** protects all following members */
+    DynMutex m_mutex;
+    /** signaled when new items are queued or m_shutdown is set */
+    Cond m_workAvailable;
+    /** signaled when an item was processed */
+    Cond m_workDone;
+    std::deque< boost::shared_ptr<T> > m_queue;
+    /** number of workers waiting for m_workAvailable */
+    int m_idle;
+    /** number of queued or running items */
+    int m_numPending;
+    bool m_shutdown;
+};
+
 #else
 
 # undef HAVE_THREAD_SUPPORT
@@ -149,6 +272,7 @@ class Cond
 {
  public:
     void signal() {}
+    void broadcast() {}
     template<class M> void wait(M &m) {}
 };
 
@@ -21,12 +21,121 @@
 #include <syncevo/TrackingSyncSource.h>
 #include <syncevo/SafeConfigNode.h>
 #include <syncevo/PrefixConfigNode.h>
+#include <syncevo/ThreadSupport.h>
 
 #include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/foreach.hpp>
+
+#include <list>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
 
+struct TrackingSyncSource::PendingInsert
+{
+    std::string m_luid;
+    std::string m_item;
+    bool m_raw;
+    InsertItemResult m_result;
+    /** if set, called instead of insertItem() */
+    boost::function<void ()> m_work;
+    /** protected by WorkQueue */
+    bool m_done;
+    /** exception thrown by insertItem(), rethrown in the main thread */
+    std::string m_failure;
+};
+
+#ifdef HAVE_THREAD_SUPPORT
+/**
+ * Single worker thread which executes TrackingSyncSource::insertItem()
+ * calls in the order in which they were scheduled.
+ */
+class TrackingSyncSource::InsertThread : private boost::noncopyable
+{
+ public:
+    InsertThread(TrackingSyncSource &source) :
+        m_source(source)
+    {
+        m_thread = g_thread_new("insert", run, this);
+    }
+
+    ~InsertThread()
+    {
+        m_queue.finish();
+        m_queue.shutdown();
+        g_thread_join(m_thread);
+    }
+
+    void schedule(const boost::shared_ptr<PendingInsert> &pending)
+    {
+        if (pending->m_work) {
+            m_work.push_back(pending);
+        }
+        m_queue.push(pending);
+    }
+
+    bool isDone(const boost::shared_ptr<PendingInsert> &pending)
+    {
+        return m_queue.isDone(pending);
+    }
+
+    /**
+     * Waits for all scheduled work. Returns the failure of the first
+     * failed PendingInsert::m_work since the last call, if any.
+     * Failures of inserts are reported via their PendingInsert.
+     */
+    std::string finish()
+    {
+        m_queue.finish();
+        std::string failure;
+        BOOST_FOREACH (const boost::shared_ptr<PendingInsert> &pending, m_work) {
+            if (!pending->m_failure.empty()) {
+                failure = pending->m_failure;
+                break;
+            }
+        }
+        m_work.clear();
+        return failure;
+    }
+
+ private:
+    TrackingSyncSource &m_source;
+    GThread *m_thread;
+    WorkQueue<PendingInsert> m_queue;
+    /** PendingInsert::m_work items scheduled since the last finish(), only used by the main thread */
+    std::list< boost::shared_ptr<PendingInsert> > m_work;
+
+    static gpointer run(gpointer data)
+    {
+        InsertThread *me = static_cast<InsertThread *>(data);
+        me->m_queue.run(boost::bind(&InsertThread::process, me, _1));
+        return NULL;
+    }
+
+    void process(PendingInsert &pending)
+    {
+        try {
+            if (pending.m_work) {
+                pending.m_work();
+            } else {
+                pending.m_result = m_source.insertItem(pending.m_luid, pending.m_item, pending.m_raw);
+            }
+        } catch (...) {
+            // Reported to the main thread by checkThreadedInsert()
+            // or waitForInserts().
+            Exception::handle(pending.m_failure, HANDLE_EXCEPTION_NO_ERROR);
+        }
+    }
+};
+#else
+class TrackingSyncSource::InsertThread
+{
+ public:
+    std::string finish() { return ""; }
+};
+#endif
+
 TrackingSyncSource::TrackingSyncSource(const SyncSourceParams &params,
                                        int granularitySeconds) :
     TestingSyncSource(params)
@@ -37,6 +146,50 @@ TrackingSyncSource::TrackingSyncSource(const SyncSourceParams &params,
     m_operations.m_checkStatus = boost::bind(&TrackingSyncSource::checkStatus, this, _1);
     m_operations.m_isEmpty = boost::bind(&TrackingSyncSource::isEmpty, this);
     SyncSourceRevisions::init(this, this, granularitySeconds, m_operations);
+    if (!getenv("SYNCEVOLUTION_NO_REVISION_HASHES")) {
+        enableRevisionHashes(boost::shared_ptr<ConfigNode>(new PrefixConfigNode("hash-", safeNode)));
+    }
+}
+
+void TrackingSyncSource::enableInsertThread()
+{
+#ifdef HAVE_THREAD_SUPPORT
+    const char *threads = getenv("SYNCEVOLUTION_SOURCE_THREADS");
+    if (!m_insertThread &&
+        !(threads && !atoi(threads))) {
+        m_insertThread.reset(new InsertThread(*this));
+        SE_LOG_DEBUG(getDisplayName(), "writing items in a separate thread");
+    }
+#endif
+}
+
+void TrackingSyncSource::scheduleWork(const boost::function<void ()> &work)
+{
+#ifdef HAVE_THREAD_SUPPORT
+    if (m_insertThread) {
+        boost::shared_ptr<PendingInsert> pending(new PendingInsert);
+        pending->m_work = work;
+        pending->m_done = false;
+        m_insertThread->schedule(pending);
+        return;
+    }
+#endif
+    work();
+}
+
+void TrackingSyncSource::waitForInserts()
+{
+    if (m_insertThread) {
+        std::string failure = m_insertThread->finish();
+        if (!failure.empty()) {
+            Exception::tryRethrow(failure, true);
+        }
+    }
+}
+
+void TrackingSyncSource::finishItemChanges()
+{
+    waitForInserts();
 }
 
 void TrackingSyncSource::checkStatus(SyncSourceReport &changes)
@@ -72,6 +225,8 @@ void TrackingSyncSource::checkStatus(SyncSourceReport &changes)
 
 void TrackingSyncSource::beginSync(const std::string &lastToken, const std::string &resumeToken)
 {
+    waitForInserts();
+
     // use the most reliable (and most expensive) method by default
     ChangeMode mode = CHANGES_FULL;
 
@@ -116,6 +271,8 @@ void TrackingSyncSource::beginSync(const std::string &lastToken, const std::stri
 
 std::string TrackingSyncSource::endSync(bool success)
 {
+    waitForInserts();
+
     // store changes persistently
     flush();
 
@@ -152,8 +309,34 @@ TrackingSyncSource::InsertItemResult TrackingSyncSource::continueInsertItem(cons
     return res;
 }
 
+TrackingSyncSource::InsertItemResult TrackingSyncSource::checkThreadedInsert(const boost::shared_ptr<PendingInsert> &pending)
+{
+#ifdef HAVE_THREAD_SUPPORT
+    if (!m_insertThread->isDone(pending)) {
+        return InsertItemResult(boost::bind(&TrackingSyncSource::checkThreadedInsert, this, pending));
+    }
+#endif
+    if (!pending->m_failure.empty()) {
+        Exception::tryRethrow(pending->m_failure, true);
+    }
+    return pending->m_result;
+}
+
 TrackingSyncSource::InsertItemResult TrackingSyncSource::doInsertItem(const std::string &luid, const std::string &item, bool raw)
 {
+#ifdef HAVE_THREAD_SUPPORT
+    if (m_insertThread) {
+        boost::shared_ptr<PendingInsert> pending(new PendingInsert);
+        pending->m_luid = luid;
+        pending->m_item = item;
+        pending->m_raw = raw;
+        pending->m_done = false;
+        m_insertThread->schedule(pending);
+        return continueInsertItem(boost::bind(&TrackingSyncSource::checkThreadedInsert, this, pending),
+                                  luid);
+    }
+#endif
+
     // insertItem() is overloaded, need to disambiguate here.
     return continueInsertItem(boost::bind(static_cast<InsertItemResult (TrackingSyncSource::*)(const std::string &luid, const std::string &item, bool raw)>(&TrackingSyncSource::insertItem),
                                           this, luid, item, raw),
@@ -178,13 +361,20 @@ TrackingSyncSource::InsertItemResult TrackingSyncSource::insertItemRaw(const std
     return res;
 }
 
+TrackingSyncSource::InsertItemResult TrackingSyncSource::insertItemRawAsync(const std::string &luid, const std::string &item)
+{
+    return doInsertItem(luid, item, true);
+}
+
 void TrackingSyncSource::readItem(const std::string &luid, std::string &item)
 {
+    waitForInserts();
     readItem(luid, item, false);
 }
 
 void TrackingSyncSource::readItemRaw(const std::string &luid, std::string &item)
 {
+    waitForInserts();
     readItem(luid, item, true);
 }
 
@@ -200,11 +390,34 @@ void TrackingSyncSource::resetDatabaseRevision()
 
 void TrackingSyncSource::deleteItem(const std::string &luid)
 {
+    waitForInserts();
     resetDatabaseRevision();
     removeItem(luid);
     deleteRevision(*m_trackingNode, luid);
 }
 
+TrackingSyncSource::DeleteItemCheck_t TrackingSyncSource::deleteItemAsync(const std::string &luid)
+{
+    waitForInserts();
+    resetDatabaseRevision();
+    DeleteItemCheck_t check = removeItemAsync(luid);
+    if (check) {
+        // Delay removing the revision.
+        return DeleteItemCheck_t(boost::bind(&TrackingSyncSource::continueDeleteItem, this, check, luid));
+    }
+    deleteRevision(*m_trackingNode, luid);
+    return DeleteItemCheck_t();
+}
+
+bool TrackingSyncSource::continueDeleteItem(const DeleteItemCheck_t &check, const std::string &luid)
+{
+    if (!check()) {
+        return false;
+    }
+    deleteRevision(*m_trackingNode, luid);
+    return true;
+}
+
 void TrackingSyncSource::enableServerMode()
 {
     SyncSourceAdmin::init(m_operations, this);
@@ -75,7 +75,10 @@ class TrackingSyncSource : public TestingSyncSource,
      *                       is based on time should specify the number
      *                       of seconds which has to pass before changes
      *                       are detected reliably (see SyncSourceRevisions
-     *                       for details), otherwise pass 0
+     *                       for details), otherwise pass 0; instead of
+     *                       waiting that long at the end of a sync, content
+     *                       hashes of recently written items are stored
+     *                       (see SyncSourceRevisions::enableRevisionHashes())
      */
     TrackingSyncSource(const SyncSourceParams &params,
                        int granularitySeconds = 1);
@@ -216,6 +219,13 @@ class TrackingSyncSource : public TestingSyncSource,
      */
     virtual void removeItem(const string &luid) = 0;
 
+    /**
+     * optional: start deleting the item and return a check
+     * which polls for completion, see
+     * SyncSourceDelete::deleteItemAsync()
+     */
+    virtual DeleteItemCheck_t removeItemAsync(const string &luid) { removeItem(luid); return DeleteItemCheck_t(); }
+
     /**
      * optional: write all changes, throw error if that fails
      *
@@ -249,6 +259,9 @@ class TrackingSyncSource : public TestingSyncSource,
 
     using SyncSource::getName;
 
+    /** waits for writes started via enableInsertThread() and scheduleWork() */
+    virtual void finishItemChanges();
+
   private:
     void checkStatus(SyncSourceReport &changes);
     boost::shared_ptr<ConfigNode> m_trackingNode;
@@ -264,21 +277,61 @@ class TrackingSyncSource : public TestingSyncSource,
     boost::shared_ptr<ConfigNode> m_metaNode;
 
  protected:
+    /**
+     * Call insertItem() in a separate thread instead of the main
+     * thread. The engine then continues with the next item while the
+     * previous one is still being written, and datastores which do
+     * this write their items in parallel instead of one after the
+     * other. All other operations (reading, deleting, beginSync(),
+     * endSync(), finishItemChanges()) first wait for pending
+     * writes.
+     *
+     * Only suitable for backends whose insertItem() neither depends
+     * on the glib main loop nor touches state that the main thread
+     * uses without first calling finishItemChanges(). Writes still
+     * happen one at a time and in the order in which they were
+     * requested.
+     *
+     * Derived classes must call finishItemChanges() in their
+     * destructor, because the thread calls their insertItem().
+     *
+     * Does nothing without thread support or when
+     * SYNCEVOLUTION_SOURCE_THREADS=0 is set.
+     */
+    void enableInsertThread();
+
+    /**
+     * Run some work after all pending writes, in the same thread as
+     * those if enableInsertThread() was called, otherwise right away.
+     * The work must obey the same rules as insertItem(). Failures are
+     * thrown by the next call which waits for pending writes.
+     */
+    void scheduleWork(const boost::function<void ()> &work);
+
     /* implementations of SyncSource callbacks */
     virtual void beginSync(const std::string &lastToken, const std::string &resumeToken);
     virtual std::string endSync(bool success);
     virtual void deleteItem(const string &luid);
+    virtual DeleteItemCheck_t deleteItemAsync(const string &luid);
     virtual InsertItemResult insertItem(const std::string &luid, const std::string &item);
     virtual void readItem(const std::string &luid, std::string &item);
     virtual InsertItemResult insertItemRaw(const std::string &luid, const std::string &item);
+    virtual InsertItemResult insertItemRawAsync(const std::string &luid, const std::string &item);
     virtual void readItemRaw(const std::string &luid, std::string &item);
     virtual void enableServerMode();
     virtual bool serverModeEnabled() const;
     virtual std::string getPeerMimeType() const;
 
  private:
+    class InsertThread;
+    struct PendingInsert;
+    boost::shared_ptr<InsertThread> m_insertThread;
+    void waitForInserts();
+    InsertItemResult checkThreadedInsert(const boost::shared_ptr<PendingInsert> &pending);
+
     InsertItemResult doInsertItem(const std::string &luid, const std::string &item, bool raw);
     InsertItemResult continueInsertItem(const boost::function<InsertItemResult ()> &check, const std::string &luid);
+    bool continueDeleteItem(const DeleteItemCheck_t &check, const std::string &luid);
     void resetDatabaseRevision();
 };
 
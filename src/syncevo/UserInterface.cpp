@@ -21,6 +21,8 @@
 #include <boost/algorithm/string/join.hpp>
 
 #include <boost/algorithm/string/join.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 
 #include <syncevo/declarations.h>
 SE_BEGIN_CXX
@@ -104,6 +106,135 @@ SavePasswordSignal &GetSavePasswordSignal()
     return savePasswordSignal;
 }
 
+LoadPasswordAsyncSignal &GetLoadPasswordAsyncSignal()
+{
+    static LoadPasswordAsyncSignal loadPasswordAsyncSignal;
+    return loadPasswordAsyncSignal;
+}
+
+void LoadPasswordAsync(const InitStateTri &keyring,
+                       const std::string &passwordName,
+                       const std::string &descr,
+                       const ConfigPasswordKey &key,
+                       const boost::function<void (const InitStateString &)> &success,
+                       const boost::function<void ()> &failureException)
+{
+    InitStateString password;
+    try {
+        if (GetLoadPasswordAsyncSignal()(keyring, passwordName, descr, key, success, failureException)) {
+            // Backend will invoke one of the callbacks.
+            return;
+        }
+        if (!GetLoadPasswordSignal()(keyring, passwordName, descr, key, password)) {
+            password = InitStateString();
+        }
+    } catch (...) {
+        failureException();
+        return;
+    }
+    success(password);
+}
+
+PasswordCache::~PasswordCache()
+{
+    clear();
+}
+
+void PasswordCache::clear()
+{
+    // Pending lookups keep their entry alive, but must not invoke
+    // callbacks of the cache owner anymore.
+    BOOST_FOREACH (const Entries_t::value_type &entry, m_entries) {
+        entry.second->m_waiting.clear();
+    }
+    m_entries.clear();
+}
+
+void PasswordCache::notify(const boost::shared_ptr<Entry> &entry,
+                           const Success_t &success,
+                           const Failure_t &failureException)
+{
+    if (entry->m_error.empty()) {
+        success(entry->m_password);
+    } else {
+        try {
+            Exception::tryRethrow(entry->m_error, true);
+        } catch (...) {
+            failureException();
+        }
+    }
+}
+
+void PasswordCache::storePassword(const boost::shared_ptr<Entry> &entry, const InitStateString &password)
+{
+    entry->m_password = password;
+    entry->m_pending = false;
+    std::list< std::pair<Success_t, Failure_t> > waiting;
+    waiting.swap(entry->m_waiting);
+    for (std::list< std::pair<Success_t, Failure_t> >::const_iterator it = waiting.begin();
+         it != waiting.end();
+         ++it) {
+        notify(entry, it->first, it->second);
+    }
+}
+
+void PasswordCache::storeError(const boost::shared_ptr<Entry> &entry)
+{
+    Exception::handle(entry->m_error, HANDLE_EXCEPTION_NO_ERROR);
+    storePassword(entry, InitStateString());
+}
+
+void PasswordCache::prefetch(const InitStateTri &keyring,
+                             const std::string &passwordName,
+                             const std::string &descr,
+                             const ConfigPasswordKey &key)
+{
+    boost::shared_ptr<Entry> &entry = m_entries[key.toString()];
+    if (entry &&
+        (entry->m_pending || entry->m_error.empty())) {
+        return;
+    }
+    entry.reset(new Entry);
+    SE_LOG_DEBUG(NULL, "looking up password for %s", key.toString().c_str());
+    // The callbacks only reference the entry, so the cache may be
+    // destroyed while a lookup is still running.
+    LoadPasswordAsync(keyring, passwordName, descr, key,
+                      boost::bind(storePassword, entry, _1),
+                      boost::bind(storeError, entry));
+}
+
+void PasswordCache::load(const InitStateTri &keyring,
+                         const std::string &passwordName,
+                         const std::string &descr,
+                         const ConfigPasswordKey &key,
+                         const Success_t &success,
+                         const Failure_t &failureException)
+{
+    prefetch(keyring, passwordName, descr, key);
+    boost::shared_ptr<Entry> entry = m_entries[key.toString()];
+    if (entry->m_pending) {
+        SE_LOG_DEBUG(NULL, "waiting for password lookup of %s", key.toString().c_str());
+        entry->m_waiting.push_back(std::make_pair(success, failureException));
+    } else {
+        SE_LOG_DEBUG(NULL, "using cached password lookup result for %s", key.toString().c_str());
+        notify(entry, success, failureException);
+    }
+}
+
+void PasswordCache::store(const ConfigPasswordKey &key, const std::string &password)
+{
+    boost::shared_ptr<Entry> &entry = m_entries[key.toString()];
+    boost::shared_ptr<Entry> old = entry;
+    entry.reset(new Entry);
+    entry->m_password = InitStateString(password, true);
+    entry->m_pending = false;
+    if (old && old->m_pending) {
+        // The keyring lookup still runs, but nobody needs to wait
+        // for it anymore.
+        storePassword(old, entry->m_password);
+    }
+}
+
 void UserInterface::askPasswordAsync(const std::string &passwordName,
                                      const std::string &descr,
                                      const ConfigPasswordKey &key,
@@ -21,8 +21,13 @@
 # define INCL_USERINTERFACE
 
 #include <string>
+#include <map>
+#include <list>
 
 #include <boost/signals2.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
 
 #include <syncevo/util.h>
 
@@ -202,6 +207,117 @@ SavePasswordSignal &GetSavePasswordSignal();
 
 static const int INTERNAL_SAVE_PASSWORD_SLOTS = 2;
 
+/**
+ * Same as LoadPasswordSignal, except that a backend which returns
+ * true only starts the lookup. It must later invoke exactly one of
+ * the two callbacks from the main loop: success with the password
+ * (unset if not found) or failureException while handling an
+ * exception.
+ *
+ * Backends are not required to support this. LoadPasswordAsync()
+ * falls back to LoadPasswordSignal if no slot handles the request.
+ */
+typedef boost::signals2::signal<bool (const InitStateTri &keyring,
+                                      const std::string &passwordName,
+                                      const std::string &descr,
+                                      const ConfigPasswordKey &key,
+                                      const boost::function<void (const InitStateString &)> &success,
+                                      const boost::function<void ()> &failureException),
+                                TrySlots> LoadPasswordAsyncSignal;
+LoadPasswordAsyncSignal &GetLoadPasswordAsyncSignal();
+
+/**
+ * Looks up a password via LoadPasswordAsyncSignal, or synchronously
+ * via LoadPasswordSignal when no backend supports asynchronous
+ * lookups. In the latter case the callbacks are invoked before
+ * returning.
+ *
+ * The success callback gets an unset password when no keyring
+ * handled the request or the password was not found.
+ */
+void LoadPasswordAsync(const InitStateTri &keyring,
+                       const std::string &passwordName,
+                       const std::string &descr,
+                       const ConfigPasswordKey &key,
+                       const boost::function<void (const InitStateString &)> &success,
+                       const boost::function<void ()> &failureException);
+
+/**
+ * Short-lived, in-memory cache of passwords retrieved from a keyring.
+ * Meant to be owned by the UserInterface of a single session, so that
+ * the same ConfigPasswordKey is looked up only once and lookups for
+ * different keys can run in parallel (see
+ * PasswordConfigProperty::prefetchPasswords()).
+ *
+ * Results are delivered via callbacks from the main loop, the cache
+ * never waits for them itself. Therefore it is only useful in
+ * processes which are prepared to continue asynchronously, like
+ * syncevo-dbus-helper.
+ *
+ * Entries are indexed by ConfigPasswordKey::toString(). The keyring
+ * setting is assumed to be the same for all calls.
+ */
+class PasswordCache : private boost::noncopyable
+{
+ public:
+    typedef boost::function<void (const InitStateString &)> Success_t;
+    typedef boost::function<void ()> Failure_t;
+
+ private:
+    struct Entry {
+        Entry() : m_pending(true) {}
+
+        bool m_pending;
+        InitStateString m_password;
+        std::string m_error;
+        /** load() calls waiting for the pending lookup */
+        std::list< std::pair<Success_t, Failure_t> > m_waiting;
+    };
+    typedef std::map<std::string, boost::shared_ptr<Entry> > Entries_t;
+    Entries_t m_entries;
+
+    static void storePassword(const boost::shared_ptr<Entry> &entry, const InitStateString &password);
+    static void storeError(const boost::shared_ptr<Entry> &entry);
+    static void notify(const boost::shared_ptr<Entry> &entry,
+                       const Success_t &success,
+                       const Failure_t &failureException);
+
+ public:
+    ~PasswordCache();
+
+    /**
+     * Start looking up the password unless already done or in
+     * progress. Returns immediately if the keyring backend supports
+     * asynchronous lookups. A lookup which failed is started again.
+     */
+    void prefetch(const InitStateTri &keyring,
+                  const std::string &passwordName,
+                  const std::string &descr,
+                  const ConfigPasswordKey &key);
+
+    /**
+     * Get password from the cache, prefetch() it if necessary. The
+     * callbacks are invoked right away if the result is known,
+     * otherwise later by the main loop, but never after the cache
+     * was destroyed. Same semantic as for LoadPasswordAsync().
+     */
+    void load(const InitStateTri &keyring,
+              const std::string &passwordName,
+              const std::string &descr,
+              const ConfigPasswordKey &key,
+              const Success_t &success,
+              const Failure_t &failureException);
+
+    /**
+     * Remember a password which was obtained some other way,
+     * for example from the user.
+     */
+    void store(const ConfigPasswordKey &key, const std::string &password);
+
+    /** forget all passwords */
+    void clear();
+};
+
 class SimpleUserInterface : public UserInterface
 {
     InitStateTri m_useKeyring;
@@ -1586,7 +1586,8 @@ context.add(test)
 
 test = SyncEvolutionTest("file", compile,
                          "", options.shell,
-                         "Client::Source::file_contact Client::Source::file_event Client::Source::file_task Client::Source::file_memo",
+                         "Client::Source::file_contact Client::Source::file_event Client::Source::file_task Client::Source::file_memo "
+                         "Client::Source::file_sharded_contact Client::Source::file_sharded_event",
                          [],
                          "CLIENT_TEST_FAILURES="
                          " "
@@ -1598,7 +1599,15 @@ test = SyncEvolutionTest("file", compile,
                          "Client::Source::file_event::LinkedItemsAllDay::testLinkedItemsInsertBothUpdateChildNoIDs,"
                          "Client::Source::file_event::LinkedItemsAllDay::testLinkedItemsUpdateChildNoIDs,"
                          "Client::Source::file_event::LinkedItemsNoTZ::testLinkedItemsInsertBothUpdateChildNoIDs,"
-                         "Client::Source::file_event::LinkedItemsNoTZ::testLinkedItemsUpdateChildNoIDs"
+                         "Client::Source::file_event::LinkedItemsNoTZ::testLinkedItemsUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsDefault::testLinkedItemsInsertBothUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsDefault::testLinkedItemsUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsWithVALARM::testLinkedItemsInsertBothUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsWithVALARM::testLinkedItemsUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsAllDay::testLinkedItemsInsertBothUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsAllDay::testLinkedItemsUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsNoTZ::testLinkedItemsInsertBothUpdateChildNoIDs,"
+                         "Client::Source::file_sharded_event::LinkedItemsNoTZ::testLinkedItemsUpdateChildNoIDs"
                          " "
                          ,
                          testPrefix=options.testprefix)
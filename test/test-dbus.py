@@ -1583,7 +1583,7 @@ class TestDBusServer(DBusUtil, unittest.TestCase):
         """TestDBusServer.testCapabilities - Server.Capabilities()"""
         capabilities = self.server.GetCapabilities()
         capabilities.sort()
-        self.assertEqual(capabilities, ['ConfigChanged', 'DatabaseProperties', 'GetConfigName', 'NamedConfig', 'Notifications', 'SessionAttach', 'SessionFlags', 'Version'])
+        self.assertEqual(capabilities, ['ConfigChanged', 'DatabaseProperties', 'GetConfigName', 'NamedConfig', 'Notifications', 'SessionAttach', 'SessionFlags', 'SuppressedSignals', 'Version'])
 
     def testVersions(self):
         """TestDBusServer.testVersions - Server.GetVersions()"""